@@ -0,0 +1,205 @@
+
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+
+#include <cstdlib>
+#include <benchmark/benchmark.h>
+#include <pinocchio/algorithm/frames.hpp>
+#include <LDSUtility.hpp>
+
+#include "consim/simulators/common.hpp"
+#include "consim/simulators/explicit_euler.hpp"
+#include "consim/simulators/exponential.hpp"
+
+#include "benchmark_utils.hpp"
+
+using namespace consim;
+using namespace consim::benchmarks;
+
+namespace
+{
+  /**
+   * Gives access to AbstractSimulator::forwardDynamics
+   */
+  class ForwardDynamicsSimulator : public EulerSimulator
+  {
+    public:
+      ForwardDynamicsSimulator(const pinocchio::Model &model, pinocchio::Data &data, int whichFD):
+      EulerSimulator(model, data, 1e-3, 1, whichFD, SEMI_IMPLICIT) {}
+
+      using AbstractSimulator::forwardDynamics;
+  };
+
+  /**
+   * Gives access to the contact dynamics of ExponentialSimulator, where the forward dynamics modes differ 
+   * in how Minv*Jc^T and Upsilon = Jc*Minv*Jc^T are computed
+   */
+  class ContactDynamicsSimulator : public ExponentialSimulator
+  {
+    public:
+      ContactDynamicsSimulator(const pinocchio::Model &model, pinocchio::Data &data, int whichFD):
+      ExponentialSimulator(model, data, 2e-3, 1, whichFD, SEMI_IMPLICIT) {}
+
+      using ExponentialSimulator::computeContactForces;
+      using ExponentialSimulator::computeExpLDS;
+      int getActiveContacts() const { return nactive_; }
+  };
+
+  /**
+   * ContactSet with all the contact points of a robot, and the data of its standing configuration
+   */
+  struct ContactFixture
+  {
+    ContactFixture(const BenchmarkRobot &robot): data(robot.model), objects(1, &getFloor())
+    {
+      for(const auto &name : robot.contact_frames)
+        contacts.add(new ContactPoint(robot.model, name, robot.model.getFrameId(name), robot.model.nv, true));
+      pinocchio::framesForwardKinematics(robot.model, data, robot.q0);
+    }
+
+    pinocchio::Data data;
+    ContactSet contacts;
+    std::vector<ContactObject*> objects;
+  };
+
+  void RobotArguments(benchmark::internal::Benchmark *b)
+  {
+    for(int robot=0; robot<N_ROBOTS; ++robot)
+      b->Arg(robot);
+  }
+
+  /**
+   * Argument: robot
+   */
+  void BM_DetectContacts(benchmark::State &state)
+  {
+    const BenchmarkRobot &robot = getRobot((RobotType) state.range(0));
+    ContactFixture fixture(robot);
+    for(auto _ : state)
+      benchmark::DoNotOptimize(detectContacts_imp(fixture.data, fixture.contacts, fixture.objects));
+    state.SetLabel(robot.name);
+  }
+
+  /**
+   * Argument: robot. Includes the forward kinematics and the contact Jacobians.
+   */
+  void BM_ComputeContactForces(benchmark::State &state)
+  {
+    const BenchmarkRobot &robot = getRobot((RobotType) state.range(0));
+    ContactFixture fixture(robot);
+    Eigen::VectorXd tau_f = Eigen::VectorXd::Zero(robot.model.nv);
+    for(auto _ : state){
+      benchmark::DoNotOptimize(computeContactForces_imp(robot.model, fixture.data, robot.q0, robot.v0, tau_f, 
+                                                        fixture.contacts, fixture.objects));
+      benchmark::ClobberMemory();
+    }
+    state.SetLabel(robot.name);
+  }
+
+  /**
+   * Arguments: robot, forward dynamics mode (1: computeMinverse, 2: ABA, 3: sparse Cholesky; 4 only differs 
+   * from 3 in ExponentialSimulator, see BM_ContactDynamics)
+   */
+  void BM_ForwardDynamics(benchmark::State &state)
+  {
+    const BenchmarkRobot &robot = getRobot((RobotType) state.range(0));
+    pinocchio::Data data(robot.model);
+    ForwardDynamicsSimulator sim(robot.model, data, (int) state.range(1));
+    Eigen::VectorXd q = robot.q0;
+    Eigen::VectorXd v = Eigen::VectorXd::Constant(robot.model.nv, 0.1);
+    Eigen::VectorXd tau = Eigen::VectorXd::Zero(robot.model.nv);
+    Eigen::VectorXd dv = Eigen::VectorXd::Zero(robot.model.nv);
+    for(auto _ : state){
+      sim.forwardDynamics(tau, dv, &q, &v);
+      benchmark::ClobberMemory();
+    }
+    state.SetLabel(robot.name);
+  }
+
+  void ForwardDynamicsArguments(benchmark::internal::Benchmark *b)
+  {
+    for(int robot=0; robot<N_ROBOTS; ++robot)
+      for(int mode=1; mode<=3; ++mode)
+        b->Args({robot, mode});
+  }
+
+  /**
+   * Arguments: robot, forward dynamics mode (1-3 as above, 4: Cholesky factorization reused for Minv*Jc^T).
+   * One exponential simulator substep without the integration: kinematics, contact detection and forces,
+   * forward dynamics and Upsilon, with all the contact points of the robot standing on the floor.
+   */
+  void BM_ContactDynamics(benchmark::State &state)
+  {
+    const BenchmarkRobot &robot = getRobot((RobotType) state.range(0));
+    pinocchio::Data data(robot.model);
+    ContactDynamicsSimulator sim(robot.model, data, (int) state.range(1));
+    sim.addObject(getFloor());
+    for(const auto &name : robot.contact_frames)
+      sim.addContactPoint(name, robot.model.getFrameId(name), true);
+    sim.resetState(robot.q0, robot.v0, true);
+    for(auto _ : state){
+      sim.computeContactForces();
+      benchmark::DoNotOptimize(sim.computeExpLDS(true));
+      benchmark::ClobberMemory();
+    }
+    state.SetLabel(robot.name);
+    state.counters["contacts"] = (double) sim.getActiveContacts();
+  }
+
+  void ContactDynamicsArguments(benchmark::internal::Benchmark *b)
+  {
+    for(int robot=0; robot<N_ROBOTS; ++robot)
+      for(int mode=1; mode<=4; ++mode)
+        b->Args({robot, mode});
+  }
+
+  /**
+   * Argument: number of active contacts. expokit integrals of the LDS of the exponential simulator,
+   *    A = [0, I; -Upsilon K, -Upsilon B]
+   * with a random positive definite Upsilon (the inverse mass seen by the contacts) and the contact 
+   * model of the other benchmarks.
+   */
+  void BM_ComputeIntegrals(benchmark::State &state)
+  {
+    const int n = 3*(int) state.range(0);
+    std::srand(1);
+    const Eigen::MatrixXd R = Eigen::MatrixXd::Random(n, n);
+    Eigen::MatrixXd Upsilon = R*R.transpose()/n;
+    Upsilon.diagonal().array() += 1.0;
+
+    Eigen::MatrixXd A = Eigen::MatrixXd::Zero(2*n, 2*n);
+    A.topRightCorner(n, n).setIdentity();
+    A.bottomLeftCorner(n, n) = -1e5*Upsilon;
+    A.bottomRightCorner(n, n) = -3e2*Upsilon;
+    const Eigen::VectorXd a = Eigen::VectorXd::Random(2*n);
+    const Eigen::VectorXd x0 = 1e-4*Eigen::VectorXd::Random(2*n);
+    Eigen::VectorXd intx(2*n), int2x(2*n);
+
+    expokit::LDSUtility<double, Eigen::Dynamic> util;
+    util.resize(2*n);
+    for(auto _ : state){
+      util.ComputeIntegrals(A, a, x0, 5e-4, intx, int2x);
+      benchmark::ClobberMemory();
+    }
+    state.counters["matrix_multiplications"] = util.getMatrixMultiplications();
+  }
+}
+
+BENCHMARK(BM_DetectContacts)->Apply(RobotArguments);
+BENCHMARK(BM_ComputeContactForces)->Apply(RobotArguments);
+BENCHMARK(BM_ForwardDynamics)->Apply(ForwardDynamicsArguments);
+BENCHMARK(BM_ContactDynamics)->Apply(ContactDynamicsArguments);
+BENCHMARK(BM_ComputeIntegrals)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,82 @@
+
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+
+#include <memory>
+#include <benchmark/benchmark.h>
+#include <Eigen/Core>
+
+#include "consim/utils/profiler.hpp"
+
+#include "benchmark_utils.hpp"
+
+using namespace consim;
+using namespace consim::benchmarks;
+
+/**
+ * Benchmarks used by compare_benchmarks.py to detect performance regressions
+ */
+namespace
+{
+  /**
+   * Fixed dense kernel (64x64 matrix products) that does not depend on consim. compare_benchmarks.py
+   * divides all the times by its time, so that baselines recorded on a different (or differently 
+   * loaded) machine can still be compared.
+   */
+  void BM_Calibration(benchmark::State &state)
+  {
+    const Eigen::MatrixXd A = Eigen::MatrixXd::Constant(64, 64, 1e-2) + Eigen::MatrixXd::Identity(64, 64);
+    const Eigen::MatrixXd B = Eigen::MatrixXd::Constant(64, 64, -1e-2) + Eigen::MatrixXd::Identity(64, 64);
+    Eigen::MatrixXd C(64, 64);
+    for(auto _ : state){
+      C.noalias() = A*B;
+      benchmark::DoNotOptimize(C.data());
+      benchmark::ClobberMemory();
+    }
+  }
+
+  /**
+   * Step of the exponential simulator (Solo, ndt=4, 4 contacts) that also reports the average time
+   * of every profiler probe, in ns, as a counter named after the probe 
+   * (e.g. exponential_simulator::computeExpLDS)
+   */
+  void BM_ProfiledStep(benchmark::State &state)
+  {
+#ifdef CONSIM_PROFILING
+    const BenchmarkRobot &robot = getRobot(SOLO);
+    pinocchio::Data data(robot.model);
+    std::unique_ptr<AbstractSimulator> sim(buildSimulator(EXPONENTIAL, robot, data, 2e-3, 4, 4));
+    Eigen::VectorXd tau = Eigen::VectorXd::Zero(robot.model.nv);
+    const bool enabled = Profiler::isEnabled();
+    Profiler::setEnabled(true);
+    Profiler::resetAll();
+    for(auto _ : state){
+      computeStandingTorques(robot, sim->get_q(), sim->get_v(), tau);
+      sim->step(tau);
+    }
+    for(const auto &name : Profiler::getProbeNames())
+      if(Profiler::getCount(name)>0)
+        state.counters[name] = 1e9*Profiler::getAverageTime(name);
+    Profiler::setEnabled(enabled);
+#else
+    state.SkipWithError("The profiling probes are not compiled (CONSIM_PROFILING is OFF)");
+    for(auto _ : state) {}
+#endif
+  }
+}
+
+BENCHMARK(BM_Calibration);
+BENCHMARK(BM_ProfiledStep)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,89 @@
+
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+
+#include <memory>
+#include <benchmark/benchmark.h>
+
+#include "benchmark_utils.hpp"
+
+using namespace consim;
+using namespace consim::benchmarks;
+
+namespace
+{
+  const double DT = 2e-3;   // control period of the Solo scripts
+
+  /**
+   * Arguments: robot, simulator, ndt, number of contact points.
+   * The robot stands on the floor under a joint PD controller; if an integrator diverges the state 
+   * is reset (outside of the timed region), so that every iteration measures a physical step.
+   */
+  void BM_Step(benchmark::State &state)
+  {
+    const BenchmarkRobot &robot = getRobot((RobotType) state.range(0));
+    const SimulatorType type = (SimulatorType) state.range(1);
+    pinocchio::Data data(robot.model);
+    std::unique_ptr<AbstractSimulator> sim(buildSimulator(type, robot, data, DT, (int) state.range(2), (int) state.range(3)));
+    Eigen::VectorXd tau = Eigen::VectorXd::Zero(robot.model.nv);
+    int64_t resets = 0;
+
+    for(auto _ : state){
+      computeStandingTorques(robot, sim->get_q(), sim->get_v(), tau);
+      sim->step(tau);
+      if(!sim->get_v().allFinite() || sim->get_v().cwiseAbs().maxCoeff() > 1e3){
+        state.PauseTiming();
+        sim->resetState(robot.q0, robot.v0, true);
+        ++resets;
+        state.ResumeTiming();
+      }
+    }
+    state.SetLabel(robot.name+"/"+getSimulatorName(type));
+    state.counters["ndt"] = (double) state.range(2);
+    state.counters["contacts"] = (double) state.range(3);
+    state.counters["substeps_per_s"] = benchmark::Counter((double) state.iterations()*state.range(2), benchmark::Counter::kIsRate);
+    state.counters["resets"] = (double) resets;
+  }
+
+  /**
+   * One benchmark family per robot: Google Benchmark warns about families with more than 100 inputs
+   */
+  template<RobotType robot>
+  void StepArguments(benchmark::internal::Benchmark *b)
+  {
+    const int ndts[] = {1, 4, 16};
+    for(int sim=0; sim<N_SIMULATORS; ++sim)
+      for(int ndt : ndts){
+        switch(robot)
+        {
+          case POINT_MASS:
+            b->Args({POINT_MASS, sim, ndt, 1});
+            break;
+          case SOLO:
+            for(int nc=1; nc<=4; ++nc)
+              b->Args({SOLO, sim, ndt, nc});
+            break;
+          default:
+            for(int nc=2; nc<=8; nc*=2)
+              b->Args({TALOS, sim, ndt, nc});
+        }
+      }
+  }
+}
+
+BENCHMARK(BM_Step)->Apply(StepArguments<POINT_MASS>)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Step)->Apply(StepArguments<SOLO>)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Step)->Apply(StepArguments<TALOS>)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,249 @@
+
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+
+#include "benchmark_utils.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <pinocchio/algorithm/joint-configuration.hpp>
+#include <pinocchio/algorithm/kinematics.hpp>
+#include <pinocchio/algorithm/frames.hpp>
+
+#include "consim/simulators/explicit_euler.hpp"
+#include "consim/simulators/rk4.hpp"
+#include "consim/simulators/implicit_euler.hpp"
+#include "consim/simulators/rigid_euler.hpp"
+#include "consim/simulators/exponential.hpp"
+
+using namespace Eigen;
+
+namespace consim
+{
+namespace benchmarks
+{
+
+namespace
+{
+  /**
+   * adds a joint with a cylindrical link of the given length hanging along -z (negative lengths point up)
+   */
+  pinocchio::JointIndex addLink(pinocchio::Model &model, pinocchio::JointIndex parent, const pinocchio::JointModel &joint,
+                                const Vector3d &offset, const std::string &name, double mass, double length)
+  {
+    const pinocchio::JointIndex id = model.addJoint(parent, joint, pinocchio::SE3(Matrix3d::Identity(), offset), name);
+    model.addJointFrame(id);
+    model.appendBodyToJoint(id, pinocchio::Inertia::FromCylinder(mass, 0.02, length),
+                            pinocchio::SE3(Matrix3d::Identity(), Vector3d(0., 0., -0.5*length)));
+    return id;
+  }
+
+  void addContactFrame(BenchmarkRobot &robot, pinocchio::JointIndex joint, const Vector3d &placement, const std::string &name)
+  {
+    pinocchio::Model &model = robot.model;
+    model.addFrame(pinocchio::Frame(name, joint, model.getFrameId(model.names[joint]), 
+                                    pinocchio::SE3(Matrix3d::Identity(), placement), pinocchio::OP_FRAME));
+    robot.contact_frames.push_back(name);
+  }
+
+  pinocchio::JointIndex addFreeFlyer(pinocchio::Model &model, const pinocchio::Inertia &inertia)
+  {
+    const pinocchio::JointIndex id = model.addJoint(0, pinocchio::JointModelFreeFlyer(), pinocchio::SE3::Identity(), "root_joint");
+    model.addJointFrame(id);
+    model.appendBodyToJoint(id, inertia, pinocchio::SE3::Identity());
+    return id;
+  }
+
+  /**
+   * sets the height of the base so that the lowest contact point is 0.1 mm below the floor
+   */
+  void placeOnFloor(BenchmarkRobot &robot)
+  {
+    pinocchio::Data data(robot.model);
+    pinocchio::framesForwardKinematics(robot.model, data, robot.q0);
+    double z_min = 1e10;
+    for(const auto &name : robot.contact_frames)
+      z_min = std::min(z_min, data.oMf[robot.model.getFrameId(name)].translation()(2));
+    robot.q0(2) -= z_min + 1e-4;
+    robot.v0 = VectorXd::Zero(robot.model.nv);
+  }
+
+  void buildPointMass(BenchmarkRobot &robot)
+  {
+    robot.name = "point_mass";
+    const pinocchio::JointIndex root = addFreeFlyer(robot.model, pinocchio::Inertia::FromSphere(1.0, 0.05));
+    addContactFrame(robot, root, Vector3d::Zero(), "ball");
+    robot.q0 = pinocchio::neutral(robot.model);
+    robot.kp = robot.kd = 0.0;
+  }
+
+  void buildSolo(BenchmarkRobot &robot)
+  {
+    robot.name = "solo";
+    pinocchio::Model &model = robot.model;
+    const pinocchio::JointIndex root = addFreeFlyer(model, pinocchio::Inertia::FromBox(1.43, 0.39, 0.17, 0.05));
+    const char *legs[] = {"FL", "FR", "HL", "HR"};
+    const double x[] = {0.1946, 0.1946, -0.1946, -0.1946};
+    const double y[] = {0.0875, -0.0875, 0.0875, -0.0875};
+    for(int i=0; i<4; ++i){
+      const std::string leg(legs[i]);
+      pinocchio::JointIndex j = addLink(model, root, pinocchio::JointModelRX(), Vector3d(x[i], y[i], 0.), leg+"_HAA", 0.15, 0.0);
+      j = addLink(model, j, pinocchio::JointModelRY(), Vector3d(0., y[i]>0 ? 0.014 : -0.014, 0.), leg+"_HFE", 0.15, 0.16);
+      j = addLink(model, j, pinocchio::JointModelRY(), Vector3d(0., 0., -0.16), leg+"_KFE", 0.03, 0.16);
+      addContactFrame(robot, j, Vector3d(0., 0., -0.16), leg+"_FOOT");
+    }
+    robot.q0 = pinocchio::neutral(model);
+    for(int i=0; i<4; ++i){
+      robot.q0(7+3*i+1) = 0.8;
+      robot.q0(7+3*i+2) = -1.6;
+    }
+    robot.kp = 10.0;
+    robot.kd = 0.05;
+  }
+
+  void buildTalos(BenchmarkRobot &robot)
+  {
+    robot.name = "talos";
+    pinocchio::Model &model = robot.model;
+    const pinocchio::JointIndex root = addFreeFlyer(model, pinocchio::Inertia::FromBox(13.5, 0.2, 0.3, 0.2));
+    const char *sides[] = {"left", "right"};
+    for(int i=0; i<2; ++i){
+      const std::string side(sides[i]);
+      const double s = i==0 ? 1.0 : -1.0;
+      pinocchio::JointIndex j = addLink(model, root, pinocchio::JointModelRZ(), Vector3d(0., s*0.085, -0.1), side+"_hip_yaw", 1.5, 0.0);
+      j = addLink(model, j, pinocchio::JointModelRX(), Vector3d::Zero(), side+"_hip_roll", 1.5, 0.0);
+      j = addLink(model, j, pinocchio::JointModelRY(), Vector3d::Zero(), side+"_hip_pitch", 6.0, 0.38);
+      j = addLink(model, j, pinocchio::JointModelRY(), Vector3d(0., 0., -0.38), side+"_knee", 3.5, 0.325);
+      j = addLink(model, j, pinocchio::JointModelRY(), Vector3d(0., 0., -0.325), side+"_ankle_pitch", 0.7, 0.0);
+      j = addLink(model, j, pinocchio::JointModelRX(), Vector3d::Zero(), side+"_ankle_roll", 1.4, 0.107);
+      for(int k=0; k<4; ++k)
+        addContactFrame(robot, j, Vector3d(k<2 ? 0.1 : -0.1, k%2==0 ? 0.065 : -0.065, -0.107), 
+                        side+"_sole_"+std::to_string(k));
+    }
+    pinocchio::JointIndex torso = addLink(model, root, pinocchio::JointModelRZ(), Vector3d(0., 0., 0.07), "torso_yaw", 2.0, 0.0);
+    torso = addLink(model, torso, pinocchio::JointModelRY(), Vector3d::Zero(), "torso_pitch", 17.9, -0.4);
+    for(int i=0; i<2; ++i){
+      const std::string side(sides[i]);
+      const double s = i==0 ? 1.0 : -1.0;
+      pinocchio::JointIndex j = addLink(model, torso, pinocchio::JointModelRY(), Vector3d(0., s*0.2, 0.4), side+"_shoulder_pitch", 1.5, 0.0);
+      j = addLink(model, j, pinocchio::JointModelRX(), Vector3d::Zero(), side+"_shoulder_roll", 1.5, 0.0);
+      j = addLink(model, j, pinocchio::JointModelRZ(), Vector3d::Zero(), side+"_shoulder_yaw", 1.8, 0.25);
+      j = addLink(model, j, pinocchio::JointModelRY(), Vector3d(0., 0., -0.25), side+"_elbow", 1.2, 0.0);
+      j = addLink(model, j, pinocchio::JointModelRZ(), Vector3d::Zero(), side+"_wrist_yaw", 1.0, 0.25);
+      j = addLink(model, j, pinocchio::JointModelRX(), Vector3d(0., 0., -0.25), side+"_wrist_roll", 0.4, 0.0);
+      j = addLink(model, j, pinocchio::JointModelRY(), Vector3d::Zero(), side+"_wrist_pitch", 0.4, 0.0);
+      addLink(model, j, pinocchio::JointModelRX(), Vector3d(0., 0., -0.05), side+"_gripper", 0.6, 0.1);
+    }
+    pinocchio::JointIndex head = addLink(model, torso, pinocchio::JointModelRZ(), Vector3d(0., 0., 0.5), "head_yaw", 0.7, 0.0);
+    addLink(model, head, pinocchio::JointModelRY(), Vector3d::Zero(), "head_pitch", 1.4, -0.2);
+
+    // slightly bent legs, with the soles parallel to the floor
+    robot.q0 = pinocchio::neutral(model);
+    for(int i=0; i<2; ++i){
+      const int leg = 7 + 6*i;
+      robot.q0(leg+2) = -0.35;
+      robot.q0(leg+3) = 0.7;
+      robot.q0(leg+4) = -0.35;
+    }
+    robot.kp = 1e3;
+    robot.kd = 10.0;
+  }
+}
+
+
+const BenchmarkRobot &getRobot(RobotType robot)
+{
+  static BenchmarkRobot robots[N_ROBOTS];
+  static bool built = false;
+  if(!built){
+    buildPointMass(robots[POINT_MASS]);
+    buildSolo(robots[SOLO]);
+    buildTalos(robots[TALOS]);
+    for(auto &r : robots)
+      placeOnFloor(r);
+    built = true;
+  }
+  if(robot<0 || robot>=N_ROBOTS)
+    throw std::runtime_error("Unknown benchmark robot "+std::to_string(robot));
+  return robots[robot];
+}
+
+
+const char *getSimulatorName(SimulatorType simulator)
+{
+  static const char *names[] = {"euler", "rk4", "implicit_euler", "rigid_euler", "exponential"};
+  if(simulator<0 || simulator>=N_SIMULATORS)
+    throw std::runtime_error("Unknown benchmark simulator "+std::to_string(simulator));
+  return names[simulator];
+}
+
+
+ContactObject &getFloor()
+{
+  static Vector3d stiffness = 1e5*Vector3d::Ones();
+  static Vector3d damping = 3e2*Vector3d::Ones();
+  static LinearPenaltyContactModel contact_model(stiffness, damping, 1.0);
+  static FloorObject floor("Floor", contact_model);
+  return floor;
+}
+
+
+AbstractSimulator *buildSimulator(SimulatorType simulator, const BenchmarkRobot &robot, pinocchio::Data &data, 
+                                  double dt, int ndt, int n_contacts, int whichFD)
+{
+  if(n_contacts<0 || n_contacts>(int)robot.contact_frames.size())
+    throw std::runtime_error("The robot "+robot.name+" has only "+std::to_string(robot.contact_frames.size())+" contact points");
+
+  AbstractSimulator *sim = NULL;
+  switch(simulator)
+  {
+    case EULER:
+      sim = new EulerSimulator(robot.model, data, dt, ndt, whichFD, SEMI_IMPLICIT);
+      break;
+    case RK4:
+      sim = new RK4Simulator(robot.model, data, dt, ndt, whichFD);
+      break;
+    case IMPLICIT_EULER:
+      sim = new ImplicitEulerSimulator(robot.model, data, dt, ndt);
+      break;
+    case RIGID_EULER:
+      sim = new RigidEulerSimulator(robot.model, data, dt, ndt);
+      break;
+    case EXPONENTIAL:
+      sim = new ExponentialSimulator(robot.model, data, dt, ndt, whichFD, SEMI_IMPLICIT);
+      break;
+    default:
+      throw std::runtime_error("Unknown benchmark simulator "+std::to_string(simulator));
+  }
+  sim->addObject(getFloor());
+  for(int i=0; i<n_contacts; ++i)
+    sim->addContactPoint(robot.contact_frames[i], robot.model.getFrameId(robot.contact_frames[i]), true);
+  sim->resetState(robot.q0, robot.v0, true);
+  return sim;
+}
+
+
+void computeStandingTorques(const BenchmarkRobot &robot, const VectorXd &q, const VectorXd &v, VectorXd &tau)
+{
+  // all the joints but the free flyer are revolute, so that nq-7 = nv-6
+  const int na = robot.model.nv-6;
+  tau.head<6>().setZero();
+  tau.tail(na) = robot.kp*(robot.q0.tail(na) - q.tail(na)) - robot.kd*v.tail(na);
+}
+
+} // namespace benchmarks
+} // namespace consim
@@ -0,0 +1,83 @@
+
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <pinocchio/multibody/model.hpp>
+#include <pinocchio/multibody/data.hpp>
+
+#include "consim/contact.hpp"
+#include "consim/object.hpp"
+#include "consim/simulators/base.hpp"
+
+namespace consim
+{
+namespace benchmarks
+{
+
+  /**
+   * Robots of the benchmarks. They are built in code with the kinematic layout and the masses of the 
+   * real robots, so that the benchmarks depend only on pinocchio (and not on example-robot-data).
+   */
+  enum RobotType { POINT_MASS=0,   /*!< free-flyer sphere, 1 contact point */
+                   SOLO=1,         /*!< Solo12-sized quadruped, 12 joints, 4 feet */
+                   TALOS=2,        /*!< Talos-sized humanoid, 32 joints, 4 contact points per sole */
+                   N_ROBOTS=3 };
+
+  enum SimulatorType { EULER=0, RK4=1, IMPLICIT_EULER=2, RIGID_EULER=3, EXPONENTIAL=4, N_SIMULATORS=5 };
+
+  struct BenchmarkRobot
+  {
+    std::string name;
+    pinocchio::Model model;
+    std::vector<std::string> contact_frames;
+    Eigen::VectorXd q0;   /*!< standing configuration, all the contact points slightly below the floor */
+    Eigen::VectorXd v0;
+    double kp, kd;        /*!< gains of the joint PD controller (see computeStandingTorques) */
+  };
+
+  /**
+   * the robots are built at the first call and never released
+   */
+  const BenchmarkRobot &getRobot(RobotType robot);
+  const char *getSimulatorName(SimulatorType simulator);
+
+  /**
+   * Floor object with the linear penalty contact model used by all the benchmarks (same parameters
+   * as the Solo scripts: K = 1e5, B = 3e2, mu = 1)
+   */
+  ContactObject &getFloor();
+
+  /**
+   * Creates a simulator of the given type for the robot, with the first n_contacts contact frames of the 
+   * robot and the floor, and resets it to the standing configuration. dt is the control period.
+   */
+  AbstractSimulator *buildSimulator(SimulatorType simulator, const BenchmarkRobot &robot, pinocchio::Data &data, 
+                                    double dt, int ndt, int n_contacts, int whichFD=3);
+
+  /**
+   * Joint PD controller holding the standing configuration, so that the state stays close to q0
+   * whatever the number of benchmark iterations
+   */
+  void computeStandingTorques(const BenchmarkRobot &robot, const Eigen::VectorXd &q, const Eigen::VectorXd &v, 
+                              Eigen::VectorXd &tau);
+
+} // namespace benchmarks
+} // namespace consim
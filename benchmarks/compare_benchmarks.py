@@ -0,0 +1,177 @@
+#!/usr/bin/env python3
+''' Compare the results of consim-benchmarks against a stored baseline.
+    Both files are the JSON output of Google Benchmark (--benchmark_out_format=json),
+    preferably recorded with --benchmark_repetitions > 1. All times are divided by the
+    time of BM_Calibration in the same file, so that a baseline recorded on another
+    machine (or under a different load) can still be compared.
+    A benchmark is a regression if its normalized time grew by more than --threshold
+    and, when both files contain repetitions, Welch's t statistic exceeds --t-critical.
+    The per-probe counters of BM_ProfiledStep (e.g. exponential_simulator::computeExpLDS)
+    are compared in the same way.
+    Exit status: 0 if no regression is found, 1 if there is a regression or if the baseline
+    file does not exist (a missing baseline is a failure of the test benchmark-regression,
+    not a silent pass).
+
+    Usage:
+        compare_benchmarks.py baseline.json current.json
+        compare_benchmarks.py --benchmark-exe ./consim-benchmarks baseline.json
+        compare_benchmarks.py --benchmark-exe ./consim-benchmarks --update baseline.json
+'''
+import argparse
+import json
+import math
+import os
+import subprocess
+import sys
+import tempfile
+
+CALIBRATION = 'BM_Calibration'
+PROFILED_STEP = 'BM_ProfiledStep'
+DEFAULT_FILTER = 'BM_Calibration|BM_ProfiledStep|BM_Step/1/4/4/4$|BM_ComputeIntegrals'
+TIME_UNITS = {'ns': 1.0, 'us': 1e3, 'ms': 1e6, 's': 1e9}
+# fields of a benchmark entry that are not user counters
+NON_COUNTERS = set(['name', 'family_index', 'per_family_instance_index', 'run_name', 'run_type',
+                    'repetitions', 'repetition_index', 'threads', 'iterations', 'real_time',
+                    'cpu_time', 'time_unit', 'aggregate_name', 'aggregate_unit', 'label',
+                    'error_occurred', 'error_message', 'skipped', 'skip_message'])
+
+
+def load_samples(filename):
+    ''' Returns {name: [cpu time in ns, one per repetition]}, with one extra entry
+        "BM_ProfiledStep:<probe>" for every profiler probe reported by BM_ProfiledStep
+    '''
+    with open(filename) as f:
+        results = json.load(f)
+    samples = {}
+    for b in results['benchmarks']:
+        if b.get('run_type', 'iteration') != 'iteration' or b.get('error_occurred', False):
+            continue
+        name = b.get('run_name', b['name'])
+        samples.setdefault(name, []).append(b['cpu_time']*TIME_UNITS[b['time_unit']])
+        if name == PROFILED_STEP:
+            for key, value in b.items():
+                if key not in NON_COUNTERS and isinstance(value, (int, float)):
+                    samples.setdefault(PROFILED_STEP+':'+key, []).append(float(value))
+    return samples
+
+
+def mean_var(x):
+    m = sum(x)/len(x)
+    var = sum((xi-m)**2 for xi in x)/(len(x)-1) if len(x) > 1 else 0.0
+    return m, var
+
+
+def normalize(samples):
+    ''' Divides all the samples by the mean time of the calibration kernel '''
+    if CALIBRATION not in samples:
+        raise RuntimeError(CALIBRATION+' is missing from the benchmark results')
+    calib, _ = mean_var(samples[CALIBRATION])
+    return dict((name, [xi/calib for xi in x]) for name, x in samples.items() if name != CALIBRATION)
+
+
+def welch_t(x, y):
+    ''' Welch's t statistic of mean(y)-mean(x), None if it cannot be computed '''
+    if len(x) < 2 or len(y) < 2:
+        return None
+    mx, vx = mean_var(x)
+    my, vy = mean_var(y)
+    se = math.sqrt(vx/len(x) + vy/len(y))
+    if se == 0.0:
+        return math.copysign(float('inf'), my-mx) if my != mx else 0.0
+    return (my-mx)/se
+
+
+def compare(baseline, current, threshold, t_critical):
+    ''' Prints the delta table and returns the names of the regressed benchmarks '''
+    base = normalize(baseline)
+    cur = normalize(current)
+    names = sorted(set(base) | set(cur), key=lambda n: (n.startswith(PROFILED_STEP+':'), n))
+    width = max([len(n) for n in names] + [len('benchmark')])
+    print('%s %12s %12s %8s %7s  %s' % ('benchmark'.ljust(width), 'baseline', 'current', 'delta', 't', 'status'))
+    print('-'*(width+55))
+    regressions = []
+    for name in names:
+        if name not in base or name not in cur:
+            print('%s %12s %12s %8s %7s  %s' % (name.ljust(width), '-' if name not in base else '%.4g' % mean_var(base[name])[0],
+                  '-' if name not in cur else '%.4g' % mean_var(cur[name])[0], '', '', 'missing' if name not in cur else 'new'))
+            continue
+        mb, _ = mean_var(base[name])
+        mc, _ = mean_var(cur[name])
+        ratio = mc/mb if mb > 0 else float('inf')
+        t = welch_t(base[name], cur[name])
+        significant = t is None or t > t_critical
+        if ratio > 1.0+threshold and significant:
+            status = 'REGRESSION'
+            regressions.append(name)
+        elif ratio < 1.0-threshold and (t is None or t < -t_critical):
+            status = 'improved'
+        else:
+            status = 'ok'
+        print('%s %12.4g %12.4g %+7.1f%% %7s  %s' % (name.ljust(width), mb, mc, 100.0*(ratio-1.0),
+              '-' if t is None else '%.1f' % t, status))
+    print('Times are relative to %s, t is the Welch t statistic (regression if delta > %+.0f%% and t > %.1f)' %
+          (CALIBRATION, 100.0*threshold, t_critical))
+    return regressions
+
+
+def run_benchmarks(exe, benchmark_filter, repetitions, out):
+    cmd = [exe, '--benchmark_filter='+benchmark_filter, '--benchmark_repetitions=%d' % repetitions,
+           '--benchmark_out='+out, '--benchmark_out_format=json']
+    print(' '.join(cmd))
+    sys.stdout.flush()
+    subprocess.check_call(cmd)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Detect performance regressions of consim-benchmarks')
+    parser.add_argument('baseline', help='baseline JSON file')
+    parser.add_argument('current', nargs='?', help='current JSON file (not needed with --benchmark-exe)')
+    parser.add_argument('--benchmark-exe', help='run this benchmark executable to get the current results')
+    parser.add_argument('--filter', default=DEFAULT_FILTER, help='benchmarks to run (default: %(default)s)')
+    parser.add_argument('--repetitions', type=int, default=5, help='repetitions of each benchmark (default: %(default)s)')
+    parser.add_argument('--threshold', type=float, default=0.2,
+                        help='relative slowdown tolerated before failing (default: %(default)s)')
+    parser.add_argument('--t-critical', type=float, default=2.5,
+                        help='Welch t statistic above which a slowdown is significant (default: %(default)s)')
+    parser.add_argument('--update', action='store_true',
+                        help='write the results of --benchmark-exe to the baseline file instead of comparing')
+    args = parser.parse_args()
+
+    if (args.current is None) == (args.benchmark_exe is None):
+        parser.error('give either the current JSON file or --benchmark-exe')
+    if args.update and args.benchmark_exe is None:
+        parser.error('--update needs --benchmark-exe')
+
+    if args.update:
+        if os.path.dirname(args.baseline) and not os.path.isdir(os.path.dirname(args.baseline)):
+            os.makedirs(os.path.dirname(args.baseline))
+        run_benchmarks(args.benchmark_exe, args.filter, args.repetitions, args.baseline)
+        print('Baseline written to '+args.baseline)
+        return 0
+
+    if not os.path.isfile(args.baseline):
+        print('No benchmark baseline '+args.baseline+', nothing to compare with. Record one with '
+              '"make update-benchmark-baseline" (or --update) on a quiet machine and commit it.')
+        return 1
+
+    if args.benchmark_exe is not None:
+        fd, current = tempfile.mkstemp(suffix='.json')
+        os.close(fd)
+        try:
+            run_benchmarks(args.benchmark_exe, args.filter, args.repetitions, current)
+            samples = load_samples(current)
+        finally:
+            os.remove(current)
+    else:
+        samples = load_samples(args.current)
+
+    regressions = compare(load_samples(args.baseline), samples, args.threshold, args.t_critical)
+    if regressions:
+        print('Performance regressions: '+', '.join(regressions))
+        return 1
+    print('No performance regression')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -35,8 +35,26 @@ using namespace boost::python;
 namespace consim 
 {
 
+double step_stats_contacts_time(const StepStats &s){ return s.getPhaseTime(StepStats::CONTACTS); }
+double step_stats_dynamics_time(const StepStats &s){ return s.getPhaseTime(StepStats::DYNAMICS); }
+double step_stats_integration_time(const StepStats &s){ return s.getPhaseTime(StepStats::INTEGRATION); }
+
 void export_base()
 {
+  bp::class_<StepStats>("StepStats", "Counters and phase times of the last step of a simulator")
+        .def_readonly("substeps", &StepStats::substeps)
+        .def_readonly("active_contacts", &StepStats::active_contacts)
+        .def_readonly("contact_changes", &StepStats::contact_changes)
+        .def_readonly("newton_iterations", &StepStats::newton_iterations)
+        .def_readonly("jacobian_updates", &StepStats::jacobian_updates)
+        .def_readonly("line_search_backtracks", &StepStats::line_search_backtracks)
+        .def_readonly("expm_squarings", &StepStats::expm_squarings)
+        .def_readonly("matrix_multiplications", &StepStats::matrix_multiplications)
+        .def_readonly("resize_events", &StepStats::resize_events)
+        .add_property("contacts_time", &step_stats_contacts_time, "time spent in kinematics, contact detection and contact forces [s]")
+        .add_property("dynamics_time", &step_stats_dynamics_time, "time spent in forward dynamics, LDS construction and Newton iterations [s]")
+        .add_property("integration_time", &step_stats_integration_time, "time spent integrating the state [s]");
+
   bp::class_<AbstractSimulatorWrapper, boost::noncopyable>("AbstractSimulator", "Abstract Simulator Class", 
                          bp::init<pinocchio::Model &, pinocchio::Data &, float, int, int, EulerIntegrationType>())
         .def("add_contact_point", &AbstractSimulatorWrapper::addContactPoint, return_internal_reference<>())
@@ -48,7 +66,8 @@ void export_base()
         .def("step", bp::pure_virtual(&AbstractSimulatorWrapper::step))
         .def("get_q", &AbstractSimulatorWrapper::get_q,bp::return_value_policy<bp::copy_const_reference>(), "configuration state vector")
         .def("get_v", &AbstractSimulatorWrapper::get_v,bp::return_value_policy<bp::copy_const_reference>(), "tangent vector to configuration")
-        .def("get_dv", &AbstractSimulatorWrapper::get_dv,bp::return_value_policy<bp::copy_const_reference>(), "time derivative of tangent vector to configuration");
+        .def("get_dv", &AbstractSimulatorWrapper::get_dv,bp::return_value_policy<bp::copy_const_reference>(), "time derivative of tangent vector to configuration")
+        .def("get_step_stats", &AbstractSimulatorWrapper::getStepStats,bp::return_value_policy<bp::copy_const_reference>(), "counters and phase times of the last step");
 
 }
 
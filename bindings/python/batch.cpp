@@ -0,0 +1,114 @@
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+
+// IMPORTANT!!!!! DO NOT CHANGE THE ORDER OF THE INCLUDES HERE (COPIED FROM TSID) 
+#include <pinocchio/fwd.hpp>
+#include <boost/python.hpp>
+#include <iostream>
+#include <string>
+#include <eigenpy/eigenpy.hpp>
+#include <boost/python/suite/indexing/vector_indexing_suite.hpp>
+#include <boost/python/make_constructor.hpp>
+
+#include <pinocchio/bindings/python/multibody/data.hpp>
+#include <pinocchio/bindings/python/multibody/model.hpp>
+
+#include "consim/bindings/python/common.hpp"
+#include "consim/bindings/python/batch.hpp"
+#include "consim/bindings/python/explicit_euler.hpp"
+#include "consim/bindings/python/implicit_euler.hpp"
+#include "consim/bindings/python/rk4.hpp"
+#include "consim/bindings/python/rigid_euler.hpp"
+#include "consim/bindings/python/exponential.hpp"
+
+namespace bp = boost::python;
+using namespace boost::python;
+
+namespace consim 
+{
+
+BatchSimulator* build_batch_simulator(
+    int n_envs, const std::string &simulator_type, float dt, int n_integration_steps, const pinocchio::Model& model,
+    Eigen::Vector3d stifness, Eigen::Vector3d damping, double frictionCoefficient, int whichFD, int type)
+{
+  BatchSimulator::SimulatorFactory factory;
+  if(simulator_type=="euler"){
+    factory = [=](const pinocchio::Model &m, pinocchio::Data &d) -> AbstractSimulator* {
+      return build_euler_simulator(dt, n_integration_steps, m, d, stifness, damping, frictionCoefficient, whichFD, type);
+    };
+  }
+  else if(simulator_type=="rk4"){
+    factory = [=](const pinocchio::Model &m, pinocchio::Data &d) -> AbstractSimulator* {
+      return build_rk4_simulator(dt, n_integration_steps, m, d, stifness, damping, frictionCoefficient, whichFD);
+    };
+  }
+  else if(simulator_type=="implicit-euler"){
+    factory = [=](const pinocchio::Model &m, pinocchio::Data &d) -> AbstractSimulator* {
+      return build_implicit_euler_simulator(dt, n_integration_steps, m, d, stifness, damping, frictionCoefficient);
+    };
+  }
+  else if(simulator_type=="rigid-euler"){
+    factory = [=](const pinocchio::Model &m, pinocchio::Data &d) -> AbstractSimulator* {
+      return build_rigid_euler_simulator(dt, n_integration_steps, m, d, stifness, damping, frictionCoefficient);
+    };
+  }
+  else if(simulator_type=="exponential"){
+    factory = [=](const pinocchio::Model &m, pinocchio::Data &d) -> AbstractSimulator* {
+      return build_exponential_abstract_simulator(dt, n_integration_steps, m, d, stifness, damping, frictionCoefficient, 
+                                                  0, false, whichFD, type==EulerIntegrationType::SEMI_IMPLICIT, 
+                                                  100, 100, true);
+    };
+  }
+  else
+    throw std::runtime_error("Unknown simulator type "+simulator_type);
+
+  return new BatchSimulator(model, n_envs, factory);
+}
+
+/**
+ * Read-only numpy views of the batch states, sharing memory with the BatchSimulator: reading 
+ * the whole batch allocates nothing. The returned array keeps the batch alive and always shows
+ * its current state.
+ */
+Eigen::Ref<const Eigen::MatrixXd> get_batch_q_view(const BatchSimulator &batch){ return batch.get_q(); }
+Eigen::Ref<const Eigen::MatrixXd> get_batch_v_view(const BatchSimulator &batch){ return batch.get_v(); }
+Eigen::Ref<const Eigen::MatrixXd> get_batch_dv_view(const BatchSimulator &batch){ return batch.get_dv(); }
+
+void export_batch()
+{
+  bp::def("build_batch_simulator", build_batch_simulator,
+          "Creates n_envs simulators of the given type sharing the same model, each one with floor object and LinearPenaltyContactModel.",
+          bp::return_value_policy<bp::manage_new_object>());
+
+  bp::class_<BatchSimulator, boost::noncopyable>("BatchSimulator", "Batch of simulators sharing the same model", bp::no_init)
+      .def("add_contact_point", &BatchSimulator::addContactPoint)
+      .def("add_object", &BatchSimulator::addObject)
+      .def("reset_state", &BatchSimulator::resetState)
+      .def("set_joint_friction", &BatchSimulator::setJointFriction)
+      .def("step", &BatchSimulator::step)
+      .def("get_number_of_environments", &BatchSimulator::getNumberOfEnvironments)
+      .def("set_number_of_threads", &BatchSimulator::setNumberOfThreads, 
+           (bp::arg("n_threads"), bp::arg("pin_threads")=true))
+      .def("get_number_of_threads", &BatchSimulator::getNumberOfThreads)
+      .def("get_q", &BatchSimulator::get_q,bp::return_value_policy<bp::copy_const_reference>(), "configurations, one column per environment")
+      .def("get_v", &BatchSimulator::get_v,bp::return_value_policy<bp::copy_const_reference>(), "velocities, one column per environment")
+      .def("get_dv", &BatchSimulator::get_dv,bp::return_value_policy<bp::copy_const_reference>(), "accelerations, one column per environment")
+      .def("get_q_view", &get_batch_q_view, bp::with_custodian_and_ward_postcall<0,1>(), "read-only nq x n_envs view of the configurations")
+      .def("get_v_view", &get_batch_v_view, bp::with_custodian_and_ward_postcall<0,1>(), "read-only nv x n_envs view of the velocities")
+      .def("get_dv_view", &get_batch_dv_view, bp::with_custodian_and_ward_postcall<0,1>(), "read-only nv x n_envs view of the accelerations");
+}
+
+}
@@ -33,6 +33,7 @@
 #include "consim/bindings/python/rk4.hpp"
 #include "consim/bindings/python/exponential.hpp"
 #include "consim/bindings/python/rigid_euler.hpp"
+#include "consim/bindings/python/batch.hpp"
 #include "consim/bindings/python/contacts.hpp"
 #include "consim/bindings/python/stop_watch.hpp"
 
@@ -52,6 +53,7 @@ BOOST_PYTHON_MODULE(libconsim_pywrap)
     export_rk4();
     export_exponential();
     export_rigid_euler();
+    export_batch();
 }
 
 }
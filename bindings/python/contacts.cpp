@@ -47,6 +47,18 @@ double frictionCoefficient, double alpha)
   return obj; 
 }
 
+/**
+ * The position, velocity, anchor point and force of a ContactPoint are views onto the storage 
+ * of its ContactSet, so they are exposed through getters/setters that copy the values.
+ */
+template<Vector3dView ContactPoint::*member>
+Eigen::Vector3d get_contact_vector(const ContactPoint &cp){ return cp.*member; }
+
+template<Vector3dView ContactPoint::*member>
+void set_contact_vector(ContactPoint &cp, const Eigen::Vector3d &value){ cp.*member = value; }
+
+#define ADD_VIEW_PROPERTY(name, ref) add_property(name, &get_contact_vector<ref>, &set_contact_vector<ref>)
+
 void export_contacts()
 {
   bp::def("create_half_plane", create_half_plane,
@@ -64,14 +76,14 @@ void export_contacts()
         .ADD_PROPERTY_RETURN_BY_VALUE("name", &ContactPoint::name_)
         .ADD_PROPERTY_RETURN_BY_VALUE("active", &ContactPoint::active)
         .ADD_PROPERTY_RETURN_BY_VALUE("slipping", &ContactPoint::slipping)
-        .ADD_PROPERTY_RETURN_BY_VALUE("x", &ContactPoint::x)
-        .ADD_PROPERTY_RETURN_BY_VALUE("v", &ContactPoint::v)
-        .ADD_PROPERTY_RETURN_BY_VALUE("x_anchor", &ContactPoint::x_anchor)
+        .ADD_VIEW_PROPERTY("x", &ContactPoint::x)
+        .ADD_VIEW_PROPERTY("v", &ContactPoint::v)
+        .ADD_VIEW_PROPERTY("x_anchor", &ContactPoint::x_anchor)
         .ADD_PROPERTY_RETURN_BY_VALUE("normal", &ContactPoint::normal)
         .ADD_PROPERTY_RETURN_BY_VALUE("normvel", &ContactPoint::normvel)
         .ADD_PROPERTY_RETURN_BY_VALUE("tangent", &ContactPoint::tangent)
         .ADD_PROPERTY_RETURN_BY_VALUE("tanvel", &ContactPoint::tanvel)
-        .ADD_PROPERTY_RETURN_BY_VALUE("f", &ContactPoint::f)
+        .ADD_VIEW_PROPERTY("f", &ContactPoint::f)
         .ADD_PROPERTY_RETURN_BY_VALUE("f_avg", &ContactPoint::f_avg)
         .ADD_PROPERTY_RETURN_BY_VALUE("f_avg2", &ContactPoint::f_avg2)
         .ADD_PROPERTY_RETURN_BY_VALUE("f_prj", &ContactPoint::f_prj)
@@ -61,19 +61,24 @@ void export_explicit_euler()
           "A simple way to create a simulator using explicit euler integration with floor object and LinearPenaltyContactModel.",
           bp::return_value_policy<bp::manage_new_object>());
 
-  bp::class_<EulerSimulator, bases<AbstractSimulatorWrapper>>("EulerSimulator",
+  bp::class_<EulerSimulator, bases<AbstractSimulatorWrapper>, boost::noncopyable>("EulerSimulator",
                         "Euler Simulator class",
                         bp::init<pinocchio::Model &, pinocchio::Data &, float, int, int, EulerIntegrationType>())
-      .def("add_contact_point", &EulerSimulator::addContactPoint, return_internal_reference<>())
+      .def("add_contact_point", &add_contact_point<EulerSimulator>, return_internal_reference<>())
       .def("get_contact", &EulerSimulator::getContact, return_internal_reference<>())
       .def("add_object", &EulerSimulator::addObject)
       .def("reset_state", &EulerSimulator::resetState)
       .def("reset_contact_anchor", &EulerSimulator::resetContactAnchorPoint)
       .def("set_joint_friction", &EulerSimulator::setJointFriction)
       .def("step", &EulerSimulator::step)
+      .def("rollout", &rollout<EulerSimulator>, (bp::arg("self"), bp::arg("tau_ff"), bp::arg("K"), bp::arg("x_ref")), ROLLOUT_DOC)
       .def("get_q", &EulerSimulator::get_q,bp::return_value_policy<bp::copy_const_reference>(), "configuration state vector")
       .def("get_v", &EulerSimulator::get_v,bp::return_value_policy<bp::copy_const_reference>(), "tangent vector to configuration")
-      .def("get_dv", &EulerSimulator::get_dv,bp::return_value_policy<bp::copy_const_reference>(), "time derivative of tangent vector to configuration");
+      .def("get_dv", &EulerSimulator::get_dv,bp::return_value_policy<bp::copy_const_reference>(), "time derivative of tangent vector to configuration")
+      .def("get_q_view", &get_q_view<EulerSimulator>, bp::with_custodian_and_ward_postcall<0,1>(), "read-only view of the configuration state vector")
+      .def("get_v_view", &get_v_view<EulerSimulator>, bp::with_custodian_and_ward_postcall<0,1>(), "read-only view of the tangent vector to configuration")
+      .def("get_dv_view", &get_dv_view<EulerSimulator>, bp::with_custodian_and_ward_postcall<0,1>(), "read-only view of the time derivative of tangent vector to configuration")
+      .def("get_contact_forces_view", &get_contact_forces_view<EulerSimulator>, bp::with_custodian_and_ward_postcall<0,1>(), "read-only 3 x nc view of the contact forces, add_contact_point raises once it has been created");
 }
 
 }
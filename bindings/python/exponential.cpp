@@ -61,30 +61,51 @@ ExponentialSimulator* build_exponential_simulator(
   return sim;
 }
 
+AbstractSimulator* build_exponential_abstract_simulator(
+    float dt, int n_integration_steps, const pinocchio::Model& model, pinocchio::Data& data,
+    Eigen::Vector3d stifness, Eigen::Vector3d damping, double frictionCoefficient, int which_slipping,
+    bool compute_predicted_forces, int whichFD, bool semi_implicit,
+    int exp_max_mat_mul, int lds_max_mat_mul, bool useMatrixBalancing)
+{
+  return build_exponential_simulator(dt, n_integration_steps, model, data, stifness, damping, frictionCoefficient, 
+                                     which_slipping, compute_predicted_forces, whichFD, semi_implicit, 
+                                     exp_max_mat_mul, lds_max_mat_mul, useMatrixBalancing);
+}
+
 void export_exponential()
 {
   bp::def("build_exponential_simulator", build_exponential_simulator,
             "A simple way to create a simulator using exponential integration with floor object and LinearPenaltyContactModel.",
             bp::return_value_policy<bp::manage_new_object>());
 
-  bp::class_<ExponentialSimulator, bases<AbstractSimulatorWrapper>>("ExponentialSimulator",
+  bp::class_<ExponentialSimulator, bases<AbstractSimulatorWrapper>, boost::noncopyable>("ExponentialSimulator",
                           "Exponential Simulator class",
                           bp::init<pinocchio::Model &, pinocchio::Data &, float, int, int, EulerIntegrationType, int, bool, int, int>())
-        .def("add_contact_point", &ExponentialSimulator::addContactPoint, return_internal_reference<>())
+        .def("add_contact_point", &add_contact_point<ExponentialSimulator>, return_internal_reference<>())
         .def("get_contact", &ExponentialSimulator::getContact, return_internal_reference<>())
         .def("add_object", &ExponentialSimulator::addObject)
         .def("reset_state", &ExponentialSimulator::resetState)
         .def("reset_contact_anchor", &ExponentialSimulator::resetContactAnchorPoint)
         .def("set_joint_friction", &ExponentialSimulator::setJointFriction)
         .def("step", &ExponentialSimulator::step)
+        .def("rollout", &rollout<ExponentialSimulator>, (bp::arg("self"), bp::arg("tau_ff"), bp::arg("K"), bp::arg("x_ref")), ROLLOUT_DOC)
         .def("get_q", &ExponentialSimulator::get_q,bp::return_value_policy<bp::copy_const_reference>(), "configuration state vector")
         .def("get_v", &ExponentialSimulator::get_v,bp::return_value_policy<bp::copy_const_reference>(), "tangent vector to configuration")
         .def("get_dv", &ExponentialSimulator::get_dv,bp::return_value_policy<bp::copy_const_reference>(), "time derivative of tangent vector to configuration")
+        .def("get_q_view", &get_q_view<ExponentialSimulator>, bp::with_custodian_and_ward_postcall<0,1>(), "read-only view of the configuration state vector")
+        .def("get_v_view", &get_v_view<ExponentialSimulator>, bp::with_custodian_and_ward_postcall<0,1>(), "read-only view of the tangent vector to configuration")
+        .def("get_dv_view", &get_dv_view<ExponentialSimulator>, bp::with_custodian_and_ward_postcall<0,1>(), "read-only view of the time derivative of tangent vector to configuration")
+        .def("get_contact_forces_view", &get_contact_forces_view<ExponentialSimulator>, bp::with_custodian_and_ward_postcall<0,1>(), "read-only 3 x nc view of the contact forces, add_contact_point raises once it has been created")
         .def("getMatrixMultiplications", &ExponentialSimulator::getMatrixMultiplications)
         .def("getMatrixExpL1Norm", &ExponentialSimulator::getMatrixExpL1Norm)
         .def("assumeSlippageContinues", &ExponentialSimulator::assumeSlippageContinues)
         .def("setUseDiagonalMatrixExp", &ExponentialSimulator::setUseDiagonalMatrixExp)
         .def("setUpdateAFrequency", &ExponentialSimulator::setUpdateAFrequency)
+        .def("setUseFixedSizeKernels", &ExponentialSimulator::setUseFixedSizeKernels)
+        .def("setUseExpmv", &ExponentialSimulator::setUseExpmv)
+        .def("getExpmvMatrixProducts", &ExponentialSimulator::getExpmvMatrixProducts)
+        .def("setUseModalExp", &ExponentialSimulator::setUseModalExp)
+        .def("setAllocationFree", &ExponentialSimulator::setAllocationFree)
         ;
 }
 
@@ -55,16 +55,27 @@ ImplicitEulerSimulator* build_implicit_euler_simulator(
   return sim;
 }
 
+/**
+ * Returns the tuple (Fx, dz) computed by ImplicitEulerSimulator::evaluateNewtonStep
+ */
+bp::tuple evaluate_newton_step(ImplicitEulerSimulator &sim, const Eigen::VectorXd &tau)
+{
+  Eigen::MatrixXd Fx;
+  Eigen::VectorXd dz;
+  sim.evaluateNewtonStep(tau, Fx, dz);
+  return bp::make_tuple(Fx, dz);
+}
+
 void export_implicit_euler()
 {
   bp::def("build_implicit_euler_simulator", build_implicit_euler_simulator,
             "A simple way to create a simulator using implicit euler integration with floor object and LinearPenaltyContactModel.",
             bp::return_value_policy<bp::manage_new_object>());
 
-  bp::class_<ImplicitEulerSimulator, bases<AbstractSimulatorWrapper>>("ImplicitEulerSimulator",
+  bp::class_<ImplicitEulerSimulator, bases<AbstractSimulatorWrapper>, boost::noncopyable>("ImplicitEulerSimulator",
                           "Implicit Euler Simulator class",
                           bp::init<pinocchio::Model &, pinocchio::Data &, float, int>())
-        .def("add_contact_point", &ImplicitEulerSimulator::addContactPoint, return_internal_reference<>())
+        .def("add_contact_point", &add_contact_point<ImplicitEulerSimulator>, return_internal_reference<>())
         .def("get_contact", &ImplicitEulerSimulator::getContact, return_internal_reference<>())
         .def("add_object", &ImplicitEulerSimulator::addObject)
         .def("reset_state", &ImplicitEulerSimulator::resetState)
@@ -74,11 +85,22 @@ void export_implicit_euler()
         .def("set_use_finite_differences_nle", &ImplicitEulerSimulator::set_use_finite_differences_nle)
         .def("set_use_current_state_as_initial_guess", &ImplicitEulerSimulator::set_use_current_state_as_initial_guess)
         .def("set_convergence_threshold", &ImplicitEulerSimulator::set_convergence_threshold)
+        .def("set_use_structured_newton_solve", &ImplicitEulerSimulator::set_use_structured_newton_solve)
+        .def("set_reuse_jacobian", &ImplicitEulerSimulator::set_reuse_jacobian)
+        .def("evaluate_newton_step", &evaluate_newton_step, (bp::arg("tau")), 
+             "evaluate_newton_step(tau) returns the Jacobian Fx of the dynamics and the first Newton step dz of a substep "
+             "starting from the current state, computed with the current options, without changing the state")
         .def("get_avg_iteration_number", &ImplicitEulerSimulator::get_avg_iteration_number)
+        .def("get_avg_jacobian_update_number", &ImplicitEulerSimulator::get_avg_jacobian_update_number)
         .def("step", &ImplicitEulerSimulator::step)
+        .def("rollout", &rollout<ImplicitEulerSimulator>, (bp::arg("self"), bp::arg("tau_ff"), bp::arg("K"), bp::arg("x_ref")), ROLLOUT_DOC)
         .def("get_q", &ImplicitEulerSimulator::get_q,bp::return_value_policy<bp::copy_const_reference>(), "configuration state vector")
         .def("get_v", &ImplicitEulerSimulator::get_v,bp::return_value_policy<bp::copy_const_reference>(), "tangent vector to configuration")
-        .def("get_dv", &ImplicitEulerSimulator::get_dv,bp::return_value_policy<bp::copy_const_reference>(), "time derivative of tangent vector to configuration");
+        .def("get_dv", &ImplicitEulerSimulator::get_dv,bp::return_value_policy<bp::copy_const_reference>(), "time derivative of tangent vector to configuration")
+        .def("get_q_view", &get_q_view<ImplicitEulerSimulator>, bp::with_custodian_and_ward_postcall<0,1>(), "read-only view of the configuration state vector")
+        .def("get_v_view", &get_v_view<ImplicitEulerSimulator>, bp::with_custodian_and_ward_postcall<0,1>(), "read-only view of the tangent vector to configuration")
+        .def("get_dv_view", &get_dv_view<ImplicitEulerSimulator>, bp::with_custodian_and_ward_postcall<0,1>(), "read-only view of the time derivative of tangent vector to configuration")
+        .def("get_contact_forces_view", &get_contact_forces_view<ImplicitEulerSimulator>, bp::with_custodian_and_ward_postcall<0,1>(), "read-only 3 x nc view of the contact forces, add_contact_point raises once it has been created");
 }
 
 }
@@ -61,10 +61,10 @@ void export_rigid_euler()
           "A simple way to create a simulator using explicit euler integration with rigid floor object.",
           bp::return_value_policy<bp::manage_new_object>());
 
-  bp::class_<RigidEulerSimulator, bases<AbstractSimulatorWrapper>>("RigidEulerSimulator",
+  bp::class_<RigidEulerSimulator, bases<AbstractSimulatorWrapper>, boost::noncopyable>("RigidEulerSimulator",
                         "Rigid Euler Simulator class",
                         bp::init<pinocchio::Model &, pinocchio::Data &, float, int>())
-      .def("add_contact_point", &RigidEulerSimulator::addContactPoint, return_internal_reference<>())
+      .def("add_contact_point", &add_contact_point<RigidEulerSimulator>, return_internal_reference<>())
       .def("get_contact", &RigidEulerSimulator::getContact, return_internal_reference<>())
       .def("add_object", &RigidEulerSimulator::addObject)
       .def("reset_state", &RigidEulerSimulator::resetState)
@@ -73,9 +73,14 @@ void export_rigid_euler()
       .def("set_contact_stabilization_gains", &RigidEulerSimulator::set_contact_stabilization_gains)
       .def("set_integration_scheme", &RigidEulerSimulator::set_integration_scheme)
       .def("step", &RigidEulerSimulator::step)
+      .def("rollout", &rollout<RigidEulerSimulator>, (bp::arg("self"), bp::arg("tau_ff"), bp::arg("K"), bp::arg("x_ref")), ROLLOUT_DOC)
       .def("get_q", &RigidEulerSimulator::get_q,bp::return_value_policy<bp::copy_const_reference>(), "configuration state vector")
       .def("get_v", &RigidEulerSimulator::get_v,bp::return_value_policy<bp::copy_const_reference>(), "tangent vector to configuration")
-      .def("get_dv", &RigidEulerSimulator::get_dv,bp::return_value_policy<bp::copy_const_reference>(), "time derivative of tangent vector to configuration");
+      .def("get_dv", &RigidEulerSimulator::get_dv,bp::return_value_policy<bp::copy_const_reference>(), "time derivative of tangent vector to configuration")
+      .def("get_q_view", &get_q_view<RigidEulerSimulator>, bp::with_custodian_and_ward_postcall<0,1>(), "read-only view of the configuration state vector")
+      .def("get_v_view", &get_v_view<RigidEulerSimulator>, bp::with_custodian_and_ward_postcall<0,1>(), "read-only view of the tangent vector to configuration")
+      .def("get_dv_view", &get_dv_view<RigidEulerSimulator>, bp::with_custodian_and_ward_postcall<0,1>(), "read-only view of the time derivative of tangent vector to configuration")
+      .def("get_contact_forces_view", &get_contact_forces_view<RigidEulerSimulator>, bp::with_custodian_and_ward_postcall<0,1>(), "read-only 3 x nc view of the contact forces, add_contact_point raises once it has been created");
 }
 
 }
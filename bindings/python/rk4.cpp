@@ -61,19 +61,24 @@ void export_rk4()
             "A simple way to create a simulator using Runge-Kutta 4 integration with floor object and LinearPenaltyContactModel.",
             bp::return_value_policy<bp::manage_new_object>());
 
-  bp::class_<RK4Simulator, bases<AbstractSimulatorWrapper>>("RK4Simulator",
+  bp::class_<RK4Simulator, bases<AbstractSimulatorWrapper>, boost::noncopyable>("RK4Simulator",
                       "Runge-Kutta 4 Simulator class",
                       bp::init<pinocchio::Model &, pinocchio::Data &, float, int, int>())
-        .def("add_contact_point", &RK4Simulator::addContactPoint, return_internal_reference<>())
+        .def("add_contact_point", &add_contact_point<RK4Simulator>, return_internal_reference<>())
         .def("get_contact", &RK4Simulator::getContact, return_internal_reference<>())
         .def("add_object", &RK4Simulator::addObject)
         .def("reset_state", &RK4Simulator::resetState)
         .def("reset_contact_anchor", &RK4Simulator::resetContactAnchorPoint)
         .def("set_joint_friction", &RK4Simulator::setJointFriction)
         .def("step", &RK4Simulator::step)
+        .def("rollout", &rollout<RK4Simulator>, (bp::arg("self"), bp::arg("tau_ff"), bp::arg("K"), bp::arg("x_ref")), ROLLOUT_DOC)
         .def("get_q", &RK4Simulator::get_q,bp::return_value_policy<bp::copy_const_reference>(), "configuration state vector")
         .def("get_v", &RK4Simulator::get_v,bp::return_value_policy<bp::copy_const_reference>(), "tangent vector to configuration")
-        .def("get_dv", &RK4Simulator::get_dv,bp::return_value_policy<bp::copy_const_reference>(), "time derivative of tangent vector to configuration");
+        .def("get_dv", &RK4Simulator::get_dv,bp::return_value_policy<bp::copy_const_reference>(), "time derivative of tangent vector to configuration")
+        .def("get_q_view", &get_q_view<RK4Simulator>, bp::with_custodian_and_ward_postcall<0,1>(), "read-only view of the configuration state vector")
+        .def("get_v_view", &get_v_view<RK4Simulator>, bp::with_custodian_and_ward_postcall<0,1>(), "read-only view of the tangent vector to configuration")
+        .def("get_dv_view", &get_dv_view<RK4Simulator>, bp::with_custodian_and_ward_postcall<0,1>(), "read-only view of the time derivative of tangent vector to configuration")
+        .def("get_contact_forces_view", &get_contact_forces_view<RK4Simulator>, bp::with_custodian_and_ward_postcall<0,1>(), "read-only 3 x nc view of the contact forces, add_contact_point raises once it has been created");
 }
 
 }
@@ -28,7 +28,7 @@
 
 #include "consim/bindings/python/common.hpp"
 #include "consim/bindings/python/stop_watch.hpp"
-#include "utils/stop-watch.h"
+#include "consim/utils/profiler.hpp"
 
 using namespace boost::python;
 
@@ -37,34 +37,78 @@ namespace consim
 
 void stop_watch_report(int precision)
 {
-  getProfiler().report_all(precision);
+  Profiler::report(precision);
 }
 
 long double stop_watch_get_average_time(const std::string & perf_name)
 {
-  return getProfiler().get_average_time(perf_name);
+  return Profiler::getAverageTime(perf_name);
 }
 
 /** Returns minimum execution time of a certain performance */
 long double stop_watch_get_min_time(const std::string & perf_name)
 {
-  return getProfiler().get_min_time(perf_name);
+  return Profiler::getMinTime(perf_name);
 }
 
 /** Returns maximum execution time of a certain performance */
 long double stop_watch_get_max_time(const std::string & perf_name)
 {
-  return getProfiler().get_max_time(perf_name);
+  return Profiler::getMaxTime(perf_name);
 }
 
 long double stop_watch_get_total_time(const std::string & perf_name)
 {
-  return getProfiler().get_total_time(perf_name);
+  return Profiler::getTotalTime(perf_name);
+}
+
+long double stop_watch_get_percentile_time(const std::string & perf_name, double p)
+{
+  return Profiler::getPercentileTime(perf_name, p);
+}
+
+/** Returns p50, p90, p99 and p99.9 of a certain performance */
+bp::tuple stop_watch_get_percentiles(const std::string & perf_name)
+{
+  return bp::make_tuple(Profiler::getPercentileTime(perf_name, 50.0), Profiler::getPercentileTime(perf_name, 90.0),
+                        Profiler::getPercentileTime(perf_name, 99.0), Profiler::getPercentileTime(perf_name, 99.9));
+}
+
+long stop_watch_get_count(const std::string & perf_name)
+{
+  return (long) Profiler::getCount(perf_name);
 }
 
 void stop_watch_reset_all()
 {
-  getProfiler().reset_all();
+  Profiler::resetAll();
+}
+
+void stop_watch_set_enabled(bool enabled)
+{
+  Profiler::setEnabled(enabled);
+}
+
+bool stop_watch_is_enabled()
+{
+  return Profiler::isEnabled();
+}
+
+void stop_watch_start_trace(int events_per_thread)
+{
+  if(events_per_thread<=0)
+    throw std::runtime_error("The trace must keep a positive number of events per thread");
+  Profiler::startTrace(events_per_thread);
+}
+
+void stop_watch_stop_trace()
+{
+  Profiler::stopTrace();
+}
+
+void stop_watch_dump_trace(const std::string & filename)
+{
+  Profiler::writeTrace(filename);
 }
 
 void export_stop_watch()
@@ -84,8 +128,32 @@ void export_stop_watch()
     bp::def("stop_watch_get_total_time", stop_watch_get_total_time,
             "Get the total time measured by the shared stop-watch for the specified task.");
 
+    bp::def("stop_watch_get_percentile_time", stop_watch_get_percentile_time,
+            "Get the time below which p percent (e.g. 99.9) of the measurements of the specified task lie.");
+
+    bp::def("stop_watch_get_percentiles", stop_watch_get_percentiles,
+            "Get the tuple (p50, p90, p99, p99.9) of the times measured for the specified task.");
+
+    bp::def("stop_watch_get_count", stop_watch_get_count,
+            "Get the number of measurements of the specified task.");
+
     bp::def("stop_watch_reset_all", stop_watch_reset_all,
             "Reset the shared stop-watch.");
+
+    bp::def("stop_watch_set_enabled", stop_watch_set_enabled,
+            "Enable or disable the profiling probes at runtime (they are compiled only with CONSIM_PROFILING).");
+
+    bp::def("stop_watch_is_enabled", stop_watch_is_enabled,
+            "True if the profiling probes are enabled.");
+
+    bp::def("stop_watch_start_trace", stop_watch_start_trace,
+            "Start recording the begin/end events of the probes, keeping the last events_per_thread events of every thread.");
+
+    bp::def("stop_watch_stop_trace", stop_watch_stop_trace,
+            "Stop recording the begin/end events of the probes.");
+
+    bp::def("stop_watch_dump_trace", stop_watch_dump_trace,
+            "Write the recorded events to a file in the Chrome trace format (chrome://tracing, ui.perfetto.dev).");
 }
 
 }
@@ -0,0 +1,45 @@
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// IMPORTANT!!!!! DO NOT CHANGE THE ORDER OF THE INCLUDES HERE (COPIED FROM TSID) 
+#include <pinocchio/fwd.hpp>
+#include <boost/python.hpp>
+#include <iostream>
+#include <string>
+#include <eigenpy/eigenpy.hpp>
+#include <boost/python/suite/indexing/vector_indexing_suite.hpp>
+#include <boost/python/make_constructor.hpp>
+
+#include <pinocchio/bindings/python/multibody/data.hpp>
+#include <pinocchio/bindings/python/multibody/model.hpp>
+#include "consim/simulators/batch.hpp"
+
+namespace consim 
+{
+
+/**
+ * Creates a batch of n_envs simulators of the given type ("euler", "rk4", "implicit-euler", 
+ * "rigid-euler" or "exponential"), each with its own floor object and LinearPenaltyContactModel.
+ */
+BatchSimulator* build_batch_simulator(
+    int n_envs, const std::string &simulator_type, float dt, int n_integration_steps, const pinocchio::Model& model,
+    Eigen::Vector3d stifness, Eigen::Vector3d damping, double frictionCoefficient, int whichFD, int type);
+
+void export_batch();
+
+}
@@ -41,6 +41,74 @@ namespace bp = boost::python;
 
 namespace consim 
 {
+
+/**
+ * Releases the GIL for the lifetime of the object.
+ * The code executed in the meantime must not touch any python object.
+ */
+class ScopedGILRelease
+{
+  public:
+    ScopedGILRelease(){ state_ = PyEval_SaveThread(); }
+    ~ScopedGILRelease(){ PyEval_RestoreThread(state_); }
+
+  private:
+    PyThreadState *state_;
+};
+
+/**
+ * Runs AbstractSimulator::rollout without holding the GIL, storing the trajectories in the buffers
+ * of the simulator. Returns the tuple (q, v, f) of new arrays with q: nq x (T+1), v: nv x (T+1), 
+ * f: 3nc x (T+1). The buffers are reallocated when T or the number of contacts change, so they 
+ * are copied instead of being shared with numpy (one copy per rollout, not per control step).
+ */
+template<typename Simulator>
+bp::tuple rollout(Simulator &sim, const Eigen::MatrixXd &tau_ff, const Eigen::MatrixXd &K, const Eigen::MatrixXd &x_ref)
+{
+  {
+    ScopedGILRelease release;
+    sim.rollout(tau_ff, K, x_ref);
+  }
+  return bp::make_tuple(sim.get_rollout_q(), sim.get_rollout_v(), sim.get_rollout_f());
+}
+
+/**
+ * Read-only numpy views sharing memory with the simulator, to avoid allocating a new array
+ * at every call. The returned array keeps the simulator alive and always shows its current state.
+ */
+template<typename Simulator>
+Eigen::Ref<const Eigen::VectorXd> get_q_view(const Simulator &sim){ return sim.get_q(); }
+
+template<typename Simulator>
+Eigen::Ref<const Eigen::VectorXd> get_v_view(const Simulator &sim){ return sim.get_v(); }
+
+template<typename Simulator>
+Eigen::Ref<const Eigen::VectorXd> get_dv_view(const Simulator &sim){ return sim.get_dv(); }
+
+/**
+ * The contact forces are reallocated when a contact point is added, so once this view has been 
+ * created add_contact_point raises an exception instead of leaving the view dangling.
+ */
+template<typename Simulator>
+Eigen::Ref<const Eigen::MatrixXd> get_contact_forces_view(bp::object self)
+{
+  const Simulator &sim = bp::extract<const Simulator&>(self);
+  self.attr("_contact_forces_shared") = true;
+  return sim.get_contact_forces();
+}
+
+template<typename Simulator>
+const ContactPoint &add_contact_point(bp::object self, const std::string &name, int frame_id, bool unilateral)
+{
+  if(bp::extract<bool>(bp::getattr(self, "_contact_forces_shared", bp::object(false))))
+    throw std::runtime_error("Contact points cannot be added after get_contact_forces_view, the view would be left dangling");
+  Simulator &sim = bp::extract<Simulator&>(self);
+  return sim.addContactPoint(name, frame_id, unilateral);
+}
+
+#define ROLLOUT_DOC "rollout(tau_ff, K, x_ref) runs T=tau_ff.shape[0] control steps with u_t = [0; tau_ff[t] + K_t (x_ref[t] - x_t)], "\
+  "where K_t = K[t*nu:(t+1)*nu,:] and nu = tau_ff.shape[1], without holding the GIL. "\
+  "Returns new arrays (q, v, f) with shapes (nq, T+1), (nv, T+1), (3*nc, T+1)."
   
 // abstract simulator wrapper for bindings 
 class AbstractSimulatorWrapper : public AbstractSimulator, public boost::python::wrapper<AbstractSimulator>
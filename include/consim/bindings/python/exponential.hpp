@@ -36,6 +36,7 @@ namespace consim
 
 // use forward declaration to work around issue of MAIN redefinition
 class ExponentialSimulator;
+class AbstractSimulator;
 
 ExponentialSimulator* build_exponential_simulator(
     float dt, int n_integration_steps, const pinocchio::Model& model, pinocchio::Data& data,
@@ -43,6 +44,16 @@ ExponentialSimulator* build_exponential_simulator(
     bool compute_predicted_forces, int whichFD, bool semi_implicit,
     int exp_max_mat_mul, int lds_max_mat_mul, bool useMatrixBalancing);
 
+/**
+ * Same as build_exponential_simulator, but returns a pointer to the base class
+ * so that other translation units can use it without including exponential.hpp
+ */
+AbstractSimulator* build_exponential_abstract_simulator(
+    float dt, int n_integration_steps, const pinocchio::Model& model, pinocchio::Data& data,
+    Eigen::Vector3d stifness, Eigen::Vector3d damping, double frictionCoefficient, int which_slipping,
+    bool compute_predicted_forces, int whichFD, bool semi_implicit,
+    int exp_max_mat_mul, int lds_max_mat_mul, bool useMatrixBalancing);
+
 void export_exponential();
 
 }
@@ -43,8 +43,22 @@ long double stop_watch_get_max_time(const std::string & perf_name);
 
 long double stop_watch_get_total_time(const std::string & perf_name);
 
+long double stop_watch_get_percentile_time(const std::string & perf_name, double p);
+
+long stop_watch_get_count(const std::string & perf_name);
+
 void stop_watch_reset_all();
 
+void stop_watch_set_enabled(bool enabled);
+
+bool stop_watch_is_enabled();
+
+void stop_watch_start_trace(int events_per_thread);
+
+void stop_watch_stop_trace();
+
+void stop_watch_dump_trace(const std::string & filename);
+
 void export_stop_watch();
 
 }
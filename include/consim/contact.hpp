@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
 #include <Eigen/Eigen>
 #include <pinocchio/multibody/model.hpp>
 #include <pinocchio/multibody/data.hpp>
@@ -30,14 +32,23 @@
 namespace consim {
 
 class ContactObject; 
+class ContactSet;
+
+typedef Eigen::Map<Eigen::Vector3d> Vector3dView;
+typedef Eigen::Map<Eigen::Matrix<double, 3, Eigen::Dynamic>, 0, Eigen::OuterStride<> > Matrix3XdView;
 
 class ContactPoint {
 
   // \brief for now will keep everything public instead of get/set methods 
+  // \brief x, v, x_anchor, v_anchor, delta_x, contactNormal_, f and world_J_ are views: 
+  // they point to the storage of the ContactSet the point belongs to, or to the 
+  // private storage of the point if it does not belong to any set
 
   public:
     ContactPoint(const pinocchio::Model &model, const std::string & name, 
     unsigned int frameId, unsigned int nv, bool isUnilateral=true); 
+    ContactPoint(const ContactPoint &other);  /*!< the copy is not attached to any ContactSet */
+    ContactPoint &operator=(const ContactPoint &other);  /*!< copies the values, keeps the views */
     ~ContactPoint() {};
 
     void updatePosition(pinocchio::Data &data);  /*!< updates cartesian position */ 
@@ -56,13 +67,13 @@ class ContactPoint {
 
     ContactObject* optr;         /*!< pointer to current contact object, changes with each new contact switch */  
 
-    Eigen::Vector3d     x_anchor;               /*!< anchor point for visco-elastic contact models  */
-    Eigen::Vector3d     v_anchor;               /*!< anchor point velocity for visco-elastic contact models  */
-    Eigen::Vector3d     x;                      /*!< contact point position in world frame */
-    Eigen::Vector3d     v;                      /*!< contact point translation velocity in world frame */
+    Vector3dView        x_anchor;               /*!< anchor point for visco-elastic contact models  */
+    Vector3dView        v_anchor;               /*!< anchor point velocity for visco-elastic contact models  */
+    Vector3dView        x;                      /*!< contact point position in world frame */
+    Vector3dView        v;                      /*!< contact point translation velocity in world frame */
     Eigen::Vector3d     dJv_; 
 
-    Eigen::MatrixXd     world_J_; 
+    Matrix3XdView       world_J_;               /*!< 3 x nv linear Jacobian in world frame */
     Eigen::MatrixXd     full_J_;  
 
     // velocity transformation from local to world 
@@ -71,12 +82,12 @@ class ContactPoint {
     pinocchio::SE3 frameSE3_ = pinocchio::SE3::Identity(); 
 
     // relative to contact object 
-    Eigen::Vector3d     delta_x;                      /*!< penetration into the object */
+    Vector3dView        delta_x;                /*!< penetration into the object */
     Eigen::Vector3d     normal;                 /*!< normal displacement vector */
     Eigen::Vector3d     normvel;                /*!< normal velocity vector */
     Eigen::Vector3d     tangent;                /*!< tangential displacement vector */
     Eigen::Vector3d     tanvel;                 /*!< tangential velocity vector */
-    Eigen::Vector3d     f;                      /*!< contact force in world coordinates */
+    Vector3dView        f;                      /*!< contact force in world coordinates */
     Eigen::Vector3d     f_avg;                  /*!< average contact force during time step */
     Eigen::Vector3d     f_avg2;                 /*!< average of average contact force during time step */
     Eigen::Vector3d     f_prj;                  /*!< projection of f_avg in friction cone */
@@ -86,10 +97,78 @@ class ContactPoint {
     Eigen::Vector3d     predictedV_;
     Eigen::Vector3d     predictedX0_;
 
-    Eigen::Vector3d    contactNormal_;
+    Vector3dView       contactNormal_;
     Eigen::Vector3d    contactTangentA_;
     Eigen::Vector3d    contactTangentB_; 
 
+  private:
+    friend class ContactSet;
+
+    /** copies all the members that are not views */
+    void copyPointState(const ContactPoint &other);
+    /** copies the members that are not views and are not recomputed by the contact kinematics */
+    void copyContactState(const ContactPoint &other);
+    /** points the views to the given 3-vectors and to the 3 x nv block J (with outer stride J_stride) */
+    void bindViews(double *x, double *v, double *x_anchor, double *v_anchor, double *delta_x, 
+                   double *normal, double *f, double *J, int nv, int J_stride);
+    void bindToOwnStorage();
+
+    Eigen::Matrix<double, 3, 7> ownData_;  /*!< storage of the 3-vector views when the point is not in a set */
+    Eigen::MatrixXd ownJ_;                 /*!< storage of world_J_ when the point is not in a set */
+}; 
+
+
+/**
+ * Structure-of-arrays storage of a set of contact points.
+ * Positions, velocities, anchor points, penetrations, normals and forces of the N points are 
+ * stored column-wise in contiguous 3 x N matrices, and the linear contact Jacobians are stacked 
+ * in a single 3N x nv matrix (rows 3i to 3i+2 belong to the i-th point). The ContactPoint objects 
+ * owned by the set are views onto these blocks, so the per-point API keeps working.
+ * The storage is reallocated only when a point is added, which invalidates external references 
+ * to the blocks (but not to the ContactPoint objects).
+ */
+class ContactSet {
+  public:
+    ContactSet() {};
+    ContactSet(const ContactSet &other);
+    ContactSet &operator=(const ContactSet &other);
+    ~ContactSet();
+
+    /**
+     * Restores the mutable contact state (activation, slipping, contact object, anchor points, 
+     * contact frames and forces) from a set with the same points, without allocating memory.
+     * Kinematic quantities (positions, velocities, Jacobians, penetrations) are not copied
+     * because they are recomputed by every contact force computation.
+     */
+    void copyStateFrom(const ContactSet &other);
+
+    /** Takes the ownership of cp and appends it to the set, cp is rebound to the set storage */
+    ContactPoint &add(ContactPoint *cp);
+
+    unsigned int size() const {return (unsigned int) points_.size();};
+    ContactPoint *operator[](unsigned int i) const {return points_[i];};
+    std::vector<ContactPoint *>::const_iterator begin() const {return points_.begin();};
+    std::vector<ContactPoint *>::const_iterator end() const {return points_.end();};
+
+    /** Rebuilds the list of the indices of the active points and returns its length */
+    int updateActiveIndices();
+    const std::vector<int> &getActiveIndices() const {return active_;};
+
+    Eigen::Matrix3Xd x;               /*!< positions in world frame */
+    Eigen::Matrix3Xd v;               /*!< velocities in world frame */
+    Eigen::Matrix3Xd x_anchor;        /*!< anchor points */
+    Eigen::Matrix3Xd v_anchor;        /*!< anchor point velocities */
+    Eigen::Matrix3Xd delta_x;         /*!< penetrations into the objects */
+    Eigen::Matrix3Xd contact_normal;  /*!< normals of the contacted objects */
+    Eigen::Matrix3Xd f;               /*!< contact forces in world coordinates */
+    Eigen::MatrixXd J;                /*!< 3N x nv stacked linear Jacobians in world frame */
+
+  private:
+    void clear();
+    void bindViews();
+
+    std::vector<ContactPoint *> points_;  /*!< owned by the set */
+    std::vector<int> active_;             /*!< indices of the active points, capacity N */
 }; 
 
 
@@ -108,6 +187,10 @@ public:
   virtual void computeForceNoUpdate(const ContactPoint &cp, Eigen::Vector3d& f) = 0;
   
   virtual void projectForceInCone(Eigen::Vector3d &f, ContactPoint& cp) = 0;
+
+  // Compute the Jacobian P of the contact force with respect to the unprojected visco-elastic 
+  // force K*delta_x - B*v, i.e. the derivative of the friction cone projection
+  virtual void computeForceProjectionJacobian(const ContactPoint &cp, Eigen::Matrix3d &P) const = 0;
   
   Eigen::Vector3d  stiffness_; 
   Eigen::Vector3d  stiffnessInverse_; 
@@ -122,14 +205,8 @@ public:
   void computeForce(ContactPoint& cp) override;
   void computeForceNoUpdate(const ContactPoint &cp, Eigen::Vector3d& f) override;
   void projectForceInCone(Eigen::Vector3d &f, ContactPoint& cp) override;
-
-  Eigen::Vector3d normalF_;
-  Eigen::Vector3d tangentF_; 
-  Eigen::Vector3d tangentDir_; 
-  double delAnchor_; 
-  double normalNorm_; 
-  double tangentNorm_; 
-  
+  void computeForceProjectionJacobian(const ContactPoint &cp, Eigen::Matrix3d &P) const override;
+  // no scratch members: a contact model can be shared by simulators running in different threads
 };
 
 }
@@ -82,9 +82,8 @@ class HalfPlaneObject: public ContactObject
   Eigen::Affine3d t_; 
 
   double plane_offset_; 
-  double distance_; 
 
-  void computeDistance(ContactPoint &cp);
+  double computeDistance(const ContactPoint &cp) const;
 
 };
 
@@ -39,7 +39,7 @@ namespace consim
     public:
       AbstractSimulator(const pinocchio::Model &model, pinocchio::Data &data, float dt, int n_integration_steps, 
                         int whichFD, EulerIntegrationType type); 
-      ~AbstractSimulator(){};
+      virtual ~AbstractSimulator(){};
 
       /**
         * Defines a pinocchio frame as a contact point for contact interaction checking.
@@ -72,9 +72,10 @@ namespace consim
        * q and dq after the step are available form the sim.q and sim.v property.
        * The acceloration during the last step is available from data.dv;
        * 
-       * The jacobian, frames etc. of data is update after the final q/v values
+       * The frames etc. of data is update after the final q/v values
        * are computed. This allows to use the data object after calling step
        * without the need to re-run the computeXXX methods etc.
+       * The joint jacobians are computed only for the joints supporting the active contacts.
        */
 
       void resetState(const Eigen::VectorXd &q, const Eigen::VectorXd &dq, bool reset_contact_state);
@@ -89,10 +90,47 @@ namespace consim
 
       virtual void step(const Eigen::VectorXd &tau)=0;
 
+      /**
+       * Runs T = tau_ff.rows() control steps applying the time-varying linear feedback law
+       *    tau_t = [0; tau_ff_t + K_t (x_ref_t - x_t)]
+       * where x_ref_t - x_t is computed on the state manifold and the zero padding (nv - nu 
+       * elements, with nu = tau_ff.cols()) accounts for unactuated joints.
+       * tau_ff is T x nu, K is (T*nu) x 2nv (K_t = K.middleRows(t*nu, nu)), x_ref is T x (nq+nv).
+       * The outputs are resized to q: nq x (T+1), v: nv x (T+1) and f: 3nc x (T+1),
+       * where the first column contains the initial state and f.col(t).segment<3>(3i) is the 
+       * force of the i-th contact point.
+       */
+      void rollout(const Eigen::MatrixXd &tau_ff, const Eigen::MatrixXd &K, const Eigen::MatrixXd &x_ref,
+                   Eigen::MatrixXd &q, Eigen::MatrixXd &v, Eigen::MatrixXd &f);
+
+      /**
+       * Same as above, but the trajectories are stored in buffers owned by the simulator (see
+       * get_rollout_q, get_rollout_v and get_rollout_f), which are reallocated only when T or the 
+       * number of contact points change and are overwritten by the next rollout.
+       */
+      void rollout(const Eigen::MatrixXd &tau_ff, const Eigen::MatrixXd &K, const Eigen::MatrixXd &x_ref)
+      { rollout(tau_ff, K, x_ref, rolloutQ_, rolloutV_, rolloutF_); }
+
+      const Eigen::MatrixXd& get_rollout_q() const {return rolloutQ_;};
+      const Eigen::MatrixXd& get_rollout_v() const {return rolloutV_;};
+      const Eigen::MatrixXd& get_rollout_f() const {return rolloutF_;};
+
       const Eigen::VectorXd& get_q() const {return q_;};
       const Eigen::VectorXd& get_v() const {return v_;};
       const Eigen::VectorXd& get_dv() const {return dv_;};
 
+      /**
+       * Contact forces of all the contact points as a 3 x nc matrix (column i is the
+       * force of the i-th contact point). This is the storage of the contact set, so it is 
+       * always up to date; it is reallocated only when a contact point is added.
+       */
+      const Eigen::Matrix3Xd& get_contact_forces() const {return contacts_.f;};
+
+      /**
+       * Counters and phase times of the last call to step()
+       */
+      const StepStats& getStepStats() const {return stepStats_;};
+
     protected:
       const pinocchio::Model *model_;
       pinocchio::Data *data_;
@@ -105,6 +143,8 @@ namespace consim
        *  1: pinocchio::computeMinverse()
        *  2: pinocchio::aba()
        *  3: cholesky decompostion 
+       *  4: cholesky decomposition, also reused for the contact terms Minv*Jc^T and Jc*Minv*Jc^T 
+       *     (ExponentialSimulator, same as 3 for the other simulators)
        **/ 
       const int whichFD_; 
       EulerIntegrationType integration_type_; // explicit euler, semi-implicit euler or classic explicit euler
@@ -118,13 +158,13 @@ namespace consim
       Eigen::VectorXd vMean_;
       Eigen::VectorXd tau_;
       unsigned int nc_=0;
-      int nactive_;         // number of active contact points
+      int nactive_=0;       // number of active contact points
       int newActive_;
       double elapsedTime_;  
       bool resetflag_ = false;
       bool contactChange_; 
 
-      std::vector<ContactPoint *> contacts_;
+      ContactSet contacts_;
       std::vector<ContactObject *> objects_;
 
       Eigen::VectorXd joint_friction_;
@@ -134,14 +174,62 @@ namespace consim
       Eigen::MatrixXd inverseM_;  /*!< used for pinocchio::computeMinverse() */ 
       Eigen::VectorXd mDv_; 
       Eigen::VectorXd fkDv_; // filled with zeros for second order kinematics  
+      Eigen::VectorXd allTermsQ_;  /*!< configuration of the last call to computeKinematicsAndDynamics */
+      Eigen::VectorXd allTermsV_;  /*!< velocity of the last call to computeKinematicsAndDynamics */
+      bool all_terms_valid_ = false;
+
+      StepStats stepStats_;
+      uint64_t phaseStart_ = 0;
+      std::vector<int> statsActiveIndices_; /*!< active contacts at the end of the previous substep, reserved to nc_ */
+
+      Eigen::MatrixXd rolloutQ_;   /*!< nq x (T+1) trajectory of the last rollout */
+      Eigen::MatrixXd rolloutV_;   /*!< nv x (T+1) trajectory of the last rollout */
+      Eigen::MatrixXd rolloutF_;   /*!< 3nc x (T+1) contact forces of the last rollout */
+      Eigen::VectorXd rolloutTau_; /*!< torques applied at each control step of a rollout */
+      Eigen::VectorXd rolloutDx_;  /*!< x_ref_t - x_t */
+      
+      /**
+        * resets stepStats_ at the beginning of step()
+      */
+      void startStepStats();
+      /**
+        * adds the time since the previous call (or since startStepStats) to the given phase
+      */
+      void lapStepPhase(StepStats::Phase phase)
+      {
+        const uint64_t now = Profiler::now();
+        stepStats_.phase_ticks[phase] += now - phaseStart_;
+        phaseStart_ = now;
+      };
+      /**
+        * counts a substep and the changes of the set of active contacts, at the end of every substep
+      */
+      void endSubstepStats();
       
       /**
         * loops over contact points, checks active contacts and sets reference contact positions 
       */
-      void detectContacts(std::vector<ContactPoint *> &contacts);
+      void detectContacts(ContactSet &contacts);
 
       void forwardDynamics(Eigen::VectorXd &tau, Eigen::VectorXd &dv, const Eigen::VectorXd *q=NULL, const Eigen::VectorXd *v=NULL); 
+      /**
+        * Computes the joint placements, velocities and accelerations (with zero joint accelerations), M, nle 
+        * and the frame placements, i.e. only the terms used by the contact kinematics and forwardDynamics 
+        * (the contact Jacobians are computed separately, see computeContactJacobians).
+        * (q, v) are stored, so that forwardDynamics does not recompute M and nle for the same state.
+      */
+      void computeKinematicsAndDynamics(const Eigen::VectorXd &q, const Eigen::VectorXd &v);
+      /**
+        * true if data_ contains M and nle computed by computeKinematicsAndDynamics at (q, v)
+      */
+      bool dynamicsCached(const Eigen::VectorXd &q, const Eigen::VectorXd &v) const
+      { return all_terms_valid_ && q==allTermsQ_ && v==allTermsV_; };
       virtual void computeContactForces()=0;
+      /**
+        * Called by resetState() to preallocate the buffers that depend on the number of active 
+        * contacts for all the nc_ contact points, so that changes of the active set do not allocate
+      */
+      virtual void reserveContactBuffers(){};
   }; // class AbstractSimulator
 
 } // namespace consim 
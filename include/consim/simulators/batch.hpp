@@ -0,0 +1,110 @@
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <Eigen/Eigen>
+#include <Eigen/Core>
+#include <pinocchio/multibody/model.hpp>
+#include <pinocchio/multibody/data.hpp>
+
+#include "consim/object.hpp"
+#include "consim/contact.hpp"
+#include "consim/simulators/base.hpp"
+#include "consim/utils/thread-pool.hpp"
+
+
+namespace consim
+{
+
+  /**
+   * Steps N independent environments (same robot, same contact setup) in a single call.
+   * The pinocchio::Model is shared by all environments, whereas every environment owns
+   * its pinocchio::Data and its simulator instance, created through a user provided factory.
+   * States are exchanged through contiguous matrices with one column per environment.
+   * Environments can be stepped in parallel by a ThreadPool: since every environment always
+   * uses its own simulator and pinocchio::Data, the results do not depend on the scheduling.
+   */
+  class BatchSimulator
+  {
+    public:
+      typedef std::function<AbstractSimulator*(const pinocchio::Model &, pinocchio::Data &)> SimulatorFactory;
+
+      BatchSimulator(const pinocchio::Model &model, int n_envs, const SimulatorFactory &factory);
+      ~BatchSimulator();
+
+      /**
+        * Defines the same contact point in all the environments
+      */
+      void addContactPoint(const std::string & name, int frame_id, bool unilateral);
+
+      /**
+        * Adds the same object to all the environments
+      */
+      void addObject(ContactObject &obj);
+
+      /**
+       * Resets the state of all the environments.
+       * q is nq x n_envs and dq is nv x n_envs, one column per environment
+       */
+      void resetState(const Eigen::MatrixXd &q, const Eigen::MatrixXd &dq, bool reset_contact_state);
+
+      void setJointFriction(const Eigen::VectorXd &joint_friction);
+
+      /**
+       * Sets the number of threads used to step the environments (1 means serial stepping,
+       * n_threads <= 0 means one thread per hardware thread). If pin_threads is true the 
+       * worker threads are pinned to consecutive cores.
+       */
+      void setNumberOfThreads(int n_threads, bool pin_threads=true);
+      int getNumberOfThreads() const {return pool_ ? pool_->getNumberOfThreads() : 1;};
+
+      /**
+       * Performs a single dt timestep in all the environments.
+       * tau is nv x n_envs, one column per environment
+       */
+      void step(const Eigen::MatrixXd &tau);
+
+      int getNumberOfEnvironments() const {return n_envs_;};
+      AbstractSimulator &getSimulator(int i);
+
+      const Eigen::MatrixXd& get_q() const {return q_;};
+      const Eigen::MatrixXd& get_v() const {return v_;};
+      const Eigen::MatrixXd& get_dv() const {return dv_;};
+
+    protected:
+      const pinocchio::Model *model_;
+      const int n_envs_;
+
+      std::vector<pinocchio::Data *> datas_;          /*!< one pinocchio::Data per environment */
+      std::vector<AbstractSimulator *> simulators_;  /*!< one simulator per environment */
+      std::vector<Eigen::VectorXd> tau_;             /*!< per environment copy of the input torques */
+      std::unique_ptr<ThreadPool> pool_;             /*!< NULL for serial stepping */
+
+      Eigen::MatrixXd q_;   /*!< nq x n_envs */
+      Eigen::MatrixXd v_;   /*!< nv x n_envs */
+      Eigen::MatrixXd dv_;  /*!< nv x n_envs */
+
+      /**
+        * Steps environment i and copies its state into the batch matrices
+      */
+      void stepEnvironment(int i);
+  }; // class BatchSimulator
+
+} // namespace consim
@@ -27,16 +27,7 @@
 #include "consim/object.hpp"
 #include "consim/contact.hpp"
 
-#include "utils/stop-watch.h"
-
-#define CONSIM_PROFILER
-#ifndef CONSIM_PROFILER
-#define CONSIM_START_PROFILER(name)
-#define CONSIM_STOP_PROFILER(name)
-#else
-#define CONSIM_START_PROFILER(name) getProfiler().start(name)
-#define CONSIM_STOP_PROFILER(name) getProfiler().stop(name)
-#endif
+#include "consim/utils/profiler.hpp"
 
 
 namespace consim {
@@ -45,17 +36,86 @@ namespace consim {
   typedef Eigen::DiagonalMatrix<double, Eigen::Dynamic> DiagonalMatrixXd;
 
   /**
-   * Detect active/inactive contact points
+   * Telemetry of the last call to AbstractSimulator::step(), filled by all the simulators without
+   * allocating memory. The counters are summed over the substeps, the counters that do not apply to a
+   * simulator stay 0. The phases are timed with Profiler::now(), also when the probes are not compiled.
+   */
+  struct StepStats
+  {
+    enum Phase { CONTACTS=0,     /*!< kinematics, contact detection and contact forces */
+                 DYNAMICS=1,     /*!< forward dynamics, construction of the LDS, Newton iterations */
+                 INTEGRATION=2,  /*!< integration of the state (including the integrals of the LDS) */
+                 N_PHASES=3 };
+
+    int substeps;
+    int active_contacts;          /*!< number of active contacts at the end of the step */
+    int contact_changes;          /*!< substeps after which the set of active contacts has changed */
+    int newton_iterations;        /*!< ImplicitEulerSimulator */
+    int jacobian_updates;         /*!< factorizations of the Newton system (ImplicitEulerSimulator) */
+    int line_search_backtracks;   /*!< ImplicitEulerSimulator */
+    int expm_squarings;           /*!< squarings of the Pade approximants (ExponentialSimulator) */
+    int matrix_multiplications;   /*!< matrix products of expokit or LDSExpmv (ExponentialSimulator) */
+    int resize_events;            /*!< rebinding or reallocation of the buffers of the contacts */
+    uint64_t phase_ticks[N_PHASES];
+
+    StepStats() { reset(); }
+
+    void reset()
+    {
+      substeps = active_contacts = contact_changes = 0;
+      newton_iterations = jacobian_updates = line_search_backtracks = 0;
+      expm_squarings = matrix_multiplications = resize_events = 0;
+      for(int i=0; i<N_PHASES; ++i)
+        phase_ticks[i] = 0;
+    }
+
+    /** time spent in a phase, in seconds */
+    double getPhaseTime(Phase phase) const { return phase_ticks[phase] * Profiler::secondsPerTick(); }
+  };
+
+  /**
+   * Sets Eigen's runtime no-malloc flag (when EIGEN_RUNTIME_NO_MALLOC is defined). The flag is a single 
+   * process-wide static, so the simulators must not toggle it while other threads are stepping: 
+   * this function does nothing in the threads where a ScopedMallocChecksSuspension is alive.
+   */
+  void setMallocAllowed(bool allowed);
+
+  /**
+   * Suspends the no-malloc checks of setMallocAllowed in the current thread for its lifetime.
+   * BatchSimulator uses it in all the workers that step environments in parallel.
+   */
+  class ScopedMallocChecksSuspension
+  {
+    public:
+      ScopedMallocChecksSuspension();
+      ~ScopedMallocChecksSuspension();
+
+    private:
+      bool previous_;
+  };
+
+  /**
+   * Detect active/inactive contact points and update the list of active indices of the set
+   */
+  int detectContacts_imp(pinocchio::Data &data, ContactSet &contacts, std::vector<ContactObject*> &objects);
+
+  /**
+   * Compute the joint Jacobians (columns of data.J) of the joints supporting the active contacts only, 
+   * rather than those of the whole tree as pinocchio::computeJointJacobians. Nothing is computed if 
+   * no contact is active. It must be called after pinocchio::forwardKinematics and detectContacts_imp.
+   * Angular and linear rows are both needed, since the linear velocity of a contact point depends on 
+   * the angular velocity of the joints supporting it.
    */
-  int detectContacts_imp(pinocchio::Data &data, std::vector<ContactPoint *> &contacts, std::vector<ContactObject*> &objects);
+  void computeContactJacobians(const pinocchio::Model &model, pinocchio::Data &data, const ContactSet &contacts);
 
   /**
    * Compute the contact forces associated to the specified list of contacts and objects. 
    * Moreover, it computes their net effect on the generalized joint torques tau_f.
+   * q and v can be segments of a state vector, they are not copied.
    */
   int computeContactForces_imp(const pinocchio::Model &model, pinocchio::Data &data, 
-                            const Eigen::VectorXd &q, const Eigen::VectorXd &v, Eigen::VectorXd &tau_f, 
-                            std::vector<ContactPoint*> &contacts, std::vector<ContactObject*> &objects);
+                            const Eigen::Ref<const Eigen::VectorXd> &q, const Eigen::Ref<const Eigen::VectorXd> &v, Eigen::VectorXd &tau_f, 
+                            ContactSet &contacts, std::vector<ContactObject*> &objects);
 
   /** 
    * Integrate in state space.
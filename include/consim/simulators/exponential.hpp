@@ -32,6 +32,11 @@
 #include "consim/contact.hpp"
 #include "eiquadprog/eiquadprog-fast.hpp"
 #include "consim/simulators/base.hpp"
+#include "consim/utils/lds-kernel.hpp"
+#include "consim/utils/lds-operators.hpp"
+#include "consim/utils/lds-expmv.hpp"
+#include "consim/utils/lds-modal.hpp"
+#include "consim/utils/view-arena.hpp"
 
 namespace consim 
 {
@@ -40,6 +45,8 @@ namespace consim
   {
 
     public:
+      EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
       /**
        * slipping metho selects anchor point update method during slipping 
        * 1: compute average force over the integration step, project on the cone boundary then update p0 
@@ -59,6 +66,33 @@ namespace consim
       void assumeSlippageContinues(bool flag){ assumeSlippageContinues_=flag; }
       void setUseDiagonalMatrixExp(bool flag){ use_diagonal_matrix_exp_=flag; }
       void setUpdateAFrequency(int f){ update_A_frequency_ = f; update_A_counter_ = 0; }
+      /**
+       * If true (default), with 1 to 4 active contacts the LDS is integrated with compile-time sized
+       * kernels rather than with expokit (which is still used for more contacts)
+       */
+      void setUseFixedSizeKernels(bool flag){ use_fixed_size_kernels_=flag; }
+      /**
+       * If true, the LDS is integrated computing only the action of the matrix exponential on vectors
+       * (truncated Taylor series, O(n^2) per matrix-vector product) rather than the full exponential.
+       * It has precedence over the fixed-size kernels, and is convenient with many active contacts.
+       */
+      void setUseExpmv(bool flag){ use_expmv_=flag; }
+      int getExpmvMatrixProducts() const { return ldsExpmv_.getMatrixProducts(); }
+      /**
+       * If true, when the damping is proportional to the stiffness (same ratio for all the active 
+       * contacts and directions) the LDS is decoupled into independent 2x2 modes through an 
+       * eigendecomposition of K^(1/2) Upsilon K^(1/2), which is computed only when A is updated.
+       * Otherwise the other methods are used.
+       */
+      void setUseModalExp(bool flag){ use_modal_exp_=flag; update_A_counter_ = 0; }
+      /**
+       * The buffers depending on the number of active contacts are always views on memory reserved 
+       * for all the contact points at resetState. If this flag is true the step is also strictly 
+       * allocation free (checked by Eigen with EIGEN_RUNTIME_NO_MALLOC): with more than 4 active 
+       * contacts (or without fixed-size kernels) the LDS is integrated with LDSExpmv rather than
+       * with expokit, and the modal decomposition is not used because the eigensolver allocates.
+       */
+      void setAllocationFree(bool flag);
 
     protected:
       /**
@@ -74,9 +108,32 @@ namespace consim
        */
       void checkFrictionCone(); 
 
+      typedef ViewArena::MatrixView MatrixView;
+      typedef ViewArena::VectorView VectorView;
+
+      void reserveContactBuffers() override;
+      /**
+       * binds the views of the contact buffers for n active contacts
+       */
+      void bindContactViews(int n);
       void resizeVectorsAndMatrices();
-      // convenience method to compute terms needed in integration  
-      void computeExpLDS(bool update_A);
+      // convenience method to compute terms needed in integration, returns true if A has changed  
+      bool computeExpLDS(bool update_A);
+      /**
+       * When the set of active contacts changes, Upsilon is not recomputed from scratch: 
+       * the blocks of the contacts that stay active are kept (moved to their new position) and only 
+       * the rows and columns of the new contacts are computed (then A is rebuilt from Upsilon).
+       * Between two updates of A (see setUpdateAFrequency) this avoids a full Jc*Minv*Jc^T product 
+       * at every touchdown and liftoff.
+       */
+      void saveUpsilonForPatch();
+      void patchUpsilon();
+      /**
+       * computes intxt_ and int2xt_ (and xT_ if a fixed-size kernel or the cached operators are used).
+       * If A is updated less often than every step, e^{dtA} and its integrals are cached
+       * and reused until the next update of A.
+       */
+      void computeIntegralsXt(bool update_A);
       
       int slipping_method_; 
       bool compute_predicted_forces_;
@@ -87,31 +144,44 @@ namespace consim
 
       bool assumeSlippageContinues_; // flag deciding whether dp0 is used in force computation 
       bool use_diagonal_matrix_exp_; // flag deciding whether a diagonal approximation of the matrix exponential is used
+      bool use_fixed_size_kernels_;  // flag deciding whether LDSKernel is used for 1 to 4 active contacts
+      bool use_expmv_;               // flag deciding whether LDSExpmv is used
+      bool use_modal_exp_;           // flag deciding whether LDSModal is used when possible
+      bool modal_valid_;             // true if ldsModal_ has been computed for the current A
+      bool xT_computed_;             // true if xT_ has been computed by the last call to computeIntegralsXt
+      bool allocation_free_;         // flag deciding whether expokit and LDSModal are avoided (see setAllocationFree)
       int update_A_frequency_;        // number of cycles after which updating the matrix A
       int update_A_counter_;
       
-      Eigen::VectorXd f_;  // contact forces
-      Eigen::MatrixXd Jc_; // contact Jacobian for all contacts 
-      Eigen::VectorXd p0_;  // anchor point positions
-      Eigen::VectorXd dp0_; // anchor point velocities
-      Eigen::VectorXd p_;   // contact point positions
-      Eigen::VectorXd dp_;  // contact point velocities
-      Eigen::VectorXd x0_;
-      Eigen::VectorXd a_;
-      Eigen::VectorXd b_;
-      Eigen::VectorXd intxt_;
-      Eigen::VectorXd int2xt_;
+      ViewArena contactArena_;  // memory of all the views below that depend on the active contacts
+      VectorView f_;  // contact forces
+      MatrixView Jc_; // contact Jacobian for all contacts 
+      VectorView p0_;  // anchor point positions
+      VectorView dp0_; // anchor point velocities
+      VectorView p_;   // contact point positions
+      VectorView dp_;  // contact point velocities
+      VectorView x0_;
+      VectorView a_;
+      VectorView b_;
+      VectorView intxt_;
+      VectorView int2xt_;
+      VectorView xT_;    // x at the end of the integration step
       Eigen::VectorXd dv_bar; 
       // contact acceleration components 
-      Eigen::VectorXd dJv_;  
-      DiagonalMatrixXd K;
-      DiagonalMatrixXd B;
-      DiagonalMatrixXd B_copy;
-      Eigen::MatrixXd D;
-      Eigen::MatrixXd A; 
-      Eigen::MatrixXd MinvJcT_;
-      Eigen::MatrixXd Upsilon_;
-      Eigen::MatrixXd JcT_; 
+      VectorView dJv_;  
+      VectorView K;       // diagonal of the stiffness matrix
+      VectorView B;       // diagonal of the damping matrix
+      VectorView B_copy;
+      MatrixView D;
+      MatrixView A; 
+      MatrixView MinvJcT_;
+      MatrixView UinvJcT_;  // D^-1/2 U^-1 Jc^T where M = U D U^T (whichFD=4)
+      MatrixView Upsilon_;
+      Eigen::MatrixXd UpsilonPrev_;      // copy of Upsilon_ before the last change of active contacts (3nc x 3nc)
+      std::vector<int> upsilonIndices_;  // indices of the contacts corresponding to the rows of Upsilon_
+      std::vector<int> upsilonPrevPos_;  // position of each active contact in UpsilonPrev_, -1 if new
+      bool upsilon_patch_pending_;       // true if Upsilon_ must be patched before being used
+      MatrixView JcT_; 
       
       // 
       void computePredictedXandF();  // predicts xf at end of integration step 
@@ -121,25 +191,33 @@ namespace consim
       expokit::MatExpIntegral<double>  util_int_eDtA_three = expokit::MatExpIntegral<double>(18);   // current implementation static 
       expokit::MatExpIntegral<double>  util_int_eDtA_four = expokit::MatExpIntegral<double>(24);   // current implementation static 
       /*!< terms to approximate integral of e^{\tau A} */ 
+      LDSKernel<6>  ldsKernelOne_;    /*!< fixed-size LDS integrators for 1 to 4 active contacts */
+      LDSKernel<12> ldsKernelTwo_;
+      LDSKernel<18> ldsKernelThree_;
+      LDSKernel<24> ldsKernelFour_;
+      LDSModal ldsModal_;                  /*!< modal decomposition of the LDS (see setUseModalExp) */
+      LDSExpmv ldsExpmv_;                  /*!< action of the exponential on vectors (see setUseExpmv) */
+      LDSIntegralOperators ldsOperators_;  /*!< cached integral operators of the last A (see setUpdateAFrequency) */
 
       Eigen::MatrixXd expAdt_; 
       Eigen::MatrixXd inteAdt_;
 
       
-      Eigen::VectorXd predictedForce_;
+      VectorView predictedForce_;
       Eigen::VectorXd predictedX0_;  
-      Eigen::VectorXd predictedXf_; 
+      VectorView predictedXf_; 
       Eigen::VectorXd dvMean_;
       Eigen::VectorXd temp01_;
       Eigen::VectorXd temp02_;
-      Eigen::VectorXd temp03_;
-      Eigen::VectorXd temp04_;
-      Eigen::MatrixXd tempStepMat_; 
+      Eigen::VectorXd sqrtDinv_;  // D^-1/2 where M = U D U^T (whichFD=4)
+      VectorView temp03_;
+      VectorView temp04_;
+      MatrixView tempStepMat_; 
       // friction cone 
-      Eigen::VectorXd f_avg;  // average force for cone 
-      Eigen::VectorXd f_avg2;  // average of average force for cone 
-      Eigen::VectorXd fpr_;   // projected force on cone boundaries 
-      Eigen::VectorXd fpr2_;   // projected force on cone boundaries
+      VectorView f_avg;  // average force for cone 
+      VectorView f_avg2;  // average of average force for cone 
+      VectorView fpr_;   // projected force on cone boundaries 
+      VectorView fpr2_;   // projected force on cone boundaries
       double cone_direction_; // angle of tangential(to contact surface) force 
 
       // Eigen::Vector3d f_avg_i; 
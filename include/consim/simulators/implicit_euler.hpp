@@ -22,6 +22,8 @@
 #include <pinocchio/multibody/model.hpp>
 #include <pinocchio/multibody/data.hpp>
 #include <pinocchio/spatial/motion.hpp>
+#include <pinocchio/spatial/force.hpp>
+#include <pinocchio/container/aligned-vector.hpp>
 
 #include "consim/simulators/explicit_euler.hpp"
 
@@ -40,6 +42,11 @@ namespace consim
       */
       void step(const Eigen::VectorXd &tau) override;
 
+      /**
+       * By default the Jacobians of the dynamics and of the nonlinear equations are computed 
+       * analytically (including sticking, slipping and released contacts), these options switch
+       * to finite differences
+      */
       void set_use_finite_differences_dynamics(bool value);
       bool get_use_finite_differences_dynamics() const;
 
@@ -52,12 +59,56 @@ namespace consim
       void set_convergence_threshold(double value);
       double get_convergence_threshold() const;
 
+      /**
+       * If true (default), the Newton system is solved through the Schur complement of its 
+       * [P, Q; -hA, I-hB] block structure, which needs a single nv x nv LU instead of a 2nv x 2nv one.
+       * Not used with finite differences of the nonlinear equations, nor with joints having more than 6 dofs.
+      */
+      void set_use_structured_newton_solve(bool value);
+      bool get_use_structured_newton_solve() const;
+
+      /**
+       * If true, the factorization of the Newton system is reused across iterations and substeps
+       * (chord method), and recomputed only when the set of active contacts changes or when an
+       * iteration does not reduce the residual by at least a factor 2
+      */
+      void set_reuse_jacobian(bool value);
+      bool get_reuse_jacobian() const;
+
+      /**
+       * Computes, without changing the state, the Jacobian Fx of the dynamics and the first Newton step dz 
+       * of a substep with input torques tau, starting from the current state as initial guess and using 
+       * the current options. Meant to check the analytic Jacobian against finite differences and the
+       * structured solve against the dense LU (see script/consim_py/test_implicit_euler_jacobians.py).
+      */
+      void evaluateNewtonStep(const Eigen::VectorXd &tau, Eigen::MatrixXd &Fx, Eigen::VectorXd &dz);
+
       double get_avg_iteration_number() const;
+      double get_avg_jacobian_update_number() const; // average number of factorizations per substep during last call to step
 
     protected:      
       int computeDynamics(const Eigen::VectorXd &tau, const Eigen::VectorXd &x, Eigen::VectorXd &f);
       void computeDynamicsJacobian(const Eigen::VectorXd &tau, const Eigen::VectorXd &x, const Eigen::VectorXd &f, Eigen::MatrixXd &Fx);
       void computeNonlinearEquations(const Eigen::VectorXd &tau, const Eigen::VectorXd &x, const Eigen::VectorXd &xNext, Eigen::VectorXd &out);
+      /**
+       * (re)allocates the contact snapshot and the contact matrices for all the nc contact points,
+       * so that the step never allocates memory, whatever the number of active contacts 
+       */
+      void allocateContactBuffers();
+      /**
+       * allocates the contact buffers and invalidates the Jacobian kept by the reuse mode
+       */
+      void reserveContactBuffers() override;
+      /**
+       * factorizes the Newton system exploiting its block structure (see set_use_structured_newton_solve)
+       */
+      void factorizeStructuredNewtonSystem();
+      void solveStructuredNewtonSystem(const Eigen::VectorXd &g, Eigen::VectorXd &dz);
+      /**
+       * computes the Newton step dz_ = -G^-1 g_ at the guess z_ (g_ is overwritten), rebuilding and 
+       * refactorizing G if update_jacobian is true
+       */
+      void computeNewtonStep(bool update_jacobian);
 
       // Eigen::VectorXd vnext_;   // guess used for the iterative search
       Eigen::VectorXd f_;       // evaluation of dynamics function
@@ -75,23 +126,46 @@ namespace consim
       // temporary variables
       Eigen::MatrixXd Dintegrate_Ddx_Fx_;
       Eigen::MatrixXd Ddifference_Dx0_Dintegrate_Ddx_Fx_;
+      Eigen::VectorXd x_eps_, dx_eps_, f_eps_;  // finite differences of the dynamics
+      Eigen::VectorXd delta_z_eps_, zEps_, gEps_; // finite differences of the nonlinear equations
 
+      // contact matrices, allocated for nc contacts and used for the first 3*nactive rows/cols
       Eigen::MatrixXd MinvJcT_;
       Eigen::MatrixXd Jc_;
-      DiagonalMatrixXd K_;
-      DiagonalMatrixXd B_;
+      Eigen::MatrixXd dF_dq_;        // derivatives of the contact forces (plus world frame correction)
+      Eigen::MatrixXd dF_dv_;
       Eigen::VectorXd lambda_;       // contact forces
+      // temporary variables of the analytic dynamics Jacobian
+      pinocchio::container::aligned_vector<pinocchio::Force> fext_; // contact forces in joint frames
+      pinocchio::Data::Matrix6x dv_dq_, dv_dv_;  // derivatives of the contact point velocity
+      Eigen::Matrix<double, 3, Eigen::Dynamic> dfraw_dq_, dfraw_dv_;  // derivatives of K*delta_x - B*v
+      Eigen::Matrix3d P_;            // Jacobian of the friction cone projection
       Eigen::VectorXd tau_plus_JT_f_;
 
       Eigen::PartialPivLU<Eigen::MatrixXd> G_LU_;
 
-      std::vector<ContactPoint *> contactsCopy_;
+      // structured Newton solve
+      typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, 6, 6> JointMatrix;
+      Eigen::MatrixXd PinvQ_;        // block diagonal P^-1*Q
+      Eigen::MatrixXd S_;            // Schur complement
+      Eigen::PartialPivLU<Eigen::MatrixXd> S_LU_;
+      std::vector<Eigen::PartialPivLU<JointMatrix>, Eigen::aligned_allocator<Eigen::PartialPivLU<JointMatrix> > > P_LU_; // one per joint
+      Eigen::VectorXd Pinv_g1_, rhs_v_;
+
+      ContactSet contactsCopy_;      // preallocated snapshot of the contacts used to evaluate the dynamics
       bool use_finite_differences_dynamics_;
       bool use_finite_differences_nle_;
       bool use_current_state_as_initial_guess_;
+      bool use_structured_newton_solve_;
+      bool reuse_jacobian_;
+      bool jacobian_valid_;         // true if G_LU_ (or S_LU_) can be reused
+      std::vector<int> jacobianIndices_; // active contacts when G_LU_ (or S_LU_) was computed
       double convergence_threshold_;
+      double jacobian_reuse_contraction_; // minimum residual reduction to keep reusing the Jacobian
       double avg_iteration_number_; // average number of iterations during last call to step
+      double avg_jacobian_update_number_;
       double regularization_;       // regularization parameter
+      double jacobian_regularization_; // regularization used in G_LU_ (or S_LU_, P_LU_ and PinvQ_)
   }; // class ImplicitEulerSimulator
 
 } // namespace consim 
@@ -24,6 +24,7 @@
 #include <pinocchio/spatial/motion.hpp>
 
 #include "consim/simulators/explicit_euler.hpp"
+#include "consim/utils/view-arena.hpp"
 
 namespace consim 
 {
@@ -45,12 +46,14 @@ namespace consim
       void set_integration_scheme(int value);
 
     protected:      
-      void computeContactForces(const Eigen::VectorXd &x, std::vector<ContactPoint *> &contacts);
+      void reserveContactBuffers() override;
+      void computeContactForces(const Eigen::VectorXd &x, ContactSet &contacts);
       void computeDynamics(const Eigen::VectorXd &tau, const Eigen::VectorXd &x, Eigen::VectorXd &f);
             
       int integration_scheme_;  // id of the integration scheme (1: Euler, 4: RK4)
-      Eigen::MatrixXd Jc_;
-      Eigen::VectorXd dJv_;
+      ViewArena contactArena_;        // memory of Jc_ and dJv_, reserved for all the contact points
+      ViewArena::MatrixView Jc_;
+      ViewArena::VectorView dJv_;
       Eigen::VectorXd x_;       // system state
       Eigen::VectorXd x_next_;  // next system state
       Eigen::VectorXd f_;       // system dynamics
@@ -60,7 +63,7 @@ namespace consim
       Eigen::VectorXd rk_factors_a_;
       Eigen::VectorXd rk_factors_b_;
 
-      std::vector<ContactPoint *> contactsCopy_;
+      ContactSet contactsCopy_;
       double avg_iteration_number_; // average number of iterations during last call to step
       double regularization_;       // regularization parameter
       double kp_, kd_;              // feedback gains for contact stabilization
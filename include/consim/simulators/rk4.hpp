@@ -47,7 +47,7 @@ namespace consim
       void step(const Eigen::VectorXd &tau) override;
 
     protected:
-      int computeContactForces(const Eigen::VectorXd &q, const Eigen::VectorXd &v, std::vector<ContactPoint*> &contacts);
+      int computeContactForces(const Eigen::VectorXd &q, const Eigen::VectorXd &v, ContactSet &contacts);
 
     private: 
       //\brief : vectors for the RK4 integration will be allocated in the constructor, depends on state dimension
@@ -57,7 +57,7 @@ namespace consim
       std::vector<double> rk_factors_;
 
       // std::vector<Eigen::VectorXd> dyi_;
-      std::vector<ContactPoint *> contactsCopy_;
+      ContactSet contactsCopy_;  /*!< preallocated snapshot of the contacts used in the intermediate stages */
   }; // class RK4Simulator
 
 } // namespace consim 
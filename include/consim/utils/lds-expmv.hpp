@@ -0,0 +1,87 @@
+
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include <Eigen/Core>
+
+#include "consim/utils/view-arena.hpp"
+
+namespace consim
+{
+
+  /**
+   * Integrates the linear dynamical system dx/dt = A x + a over [0, T] computing only the action 
+   * of the matrix exponential on a few vectors, as in A. H. Al-Mohy and N. J. Higham, "Computing the
+   * Action of the Matrix Exponential, with an Application to Exponential Integrators", SIAM J. Sci.
+   * Comput., 2011. As in LDSKernel, the exponential of the augmented matrix M = [A, W; 0, J] is used,
+   * but here it is applied to the three vectors giving x(T), int x and int int x through a truncated
+   * Taylor series, so the cost is O(n^2) per matrix-vector product instead of O(n^3).
+   */
+  class LDSExpmv
+  {
+    public:
+      typedef ViewArena::MatrixView MatrixView;
+      typedef ViewArena::VectorView VectorView;
+
+      LDSExpmv();
+
+      /**
+       * sets the size of the system; memory is allocated only if n exceeds the reserved capacity
+       */
+      void resize(int n);
+      /**
+       * preallocates memory for systems up to size n_max
+       */
+      void reserve(int n_max);
+
+      void compute(const Eigen::Ref<const Eigen::MatrixXd> &A, const Eigen::Ref<const Eigen::VectorXd> &a,
+                   const Eigen::Ref<const Eigen::VectorXd> &x0, double T,
+                   Eigen::Ref<Eigen::VectorXd> xT, Eigen::Ref<Eigen::VectorXd> intx, Eigen::Ref<Eigen::VectorXd> int2x);
+
+      int size() const { return n_; }
+      /**
+       * number of scaling steps, degree of the Taylor polynomial and number of matrix products 
+       * used by the last call to compute
+       */
+      int getSteps() const { return steps_; }
+      int getDegree() const { return degree_; }
+      int getMatrixProducts() const { return products_; }
+
+    protected:
+      /**
+       * selects the number of steps s and the degree m that minimize s*m, with s = ceil(norm/theta_m) 
+       */
+      void selectParameters(double norm);
+      /**
+       * replaces M with D^-1 M D, with D = diag(d_) chosen to reduce the norm of M
+       */
+      void balance();
+      void bindViews(int n);
+
+      int n_;
+      int steps_;
+      int degree_;
+      int products_;
+      ViewArena arena_;
+      MatrixView M_;   /*!< (n+3)x(n+3) augmented matrix, shifted by mu*I and balanced */
+      VectorView d_;   /*!< balancing scaling */
+      MatrixView F_;   /*!< (n+3)x3 result */
+      MatrixView B_;   /*!< (n+3)x3 current Taylor term */
+      MatrixView tmp_;
+  }; // class LDSExpmv
+
+} // namespace consim
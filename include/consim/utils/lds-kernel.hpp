@@ -0,0 +1,180 @@
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+#include <Eigen/Core>
+#include <Eigen/LU>
+
+namespace consim
+{
+
+  /**
+   * Matrix exponential of a fixed-size matrix with Pade approximants and scaling and squaring, see
+   * N. J. Higham, "The Scaling and Squaring Method for the Matrix Exponential Revisited", SIAM J. 
+   * Matrix Anal. Appl., 2005. The workspace is a member, so nothing is allocated on the heap.
+   */
+  template<int Size>
+  class PadeMatrixExponential
+  {
+    public:
+      typedef Eigen::Matrix<double, Size, Size> Matrix;
+
+      EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+      PadeMatrixExponential(): squarings_(0) {}
+
+      void compute(const Matrix &X, Matrix &E)
+      {
+        static const double theta[] = {1.495585217958292e-2, 2.539398330063230e-1, 9.504178996162932e-1,
+                                        2.097847961257068e0, 5.371920351148152e0};
+        static const double b3[] = {120., 60., 12., 1.};
+        static const double b5[] = {30240., 15120., 3360., 420., 30., 1.};
+        static const double b7[] = {17297280., 8648640., 1995840., 277200., 25200., 1512., 56., 1.};
+        static const double b9[] = {17643225600., 8821612800., 2075673600., 302702400., 30270240.,
+                                     2162160., 110880., 3960., 90., 1.};
+        static const double b13[] = {64764752532480000., 32382376266240000., 7771770303897600.,
+                                      1187353796428800., 129060195264000., 10559470521600., 670442572800.,
+                                      33522128640., 1323241920., 40840800., 960960., 16380., 182., 1.};
+
+        const double norm = X.cwiseAbs().colwise().sum().maxCoeff();
+        squarings_ = 0;
+        X2_.noalias() = X*X;
+        if(norm <= theta[0])
+          padeLowDegree(X, b3, 3);
+        else if(norm <= theta[1])
+          padeLowDegree(X, b5, 5);
+        else if(norm <= theta[2])
+          padeLowDegree(X, b7, 7);
+        else if(norm <= theta[3])
+          padeLowDegree(X, b9, 9);
+        else
+        {
+          squarings_ = std::max(0, int(std::ceil(std::log2(norm/theta[4]))));
+          const double s = std::ldexp(1.0, -squarings_);
+          Xs_ = s*X;
+          X2_ *= s*s;
+          X4_.noalias() = X2_*X2_;
+          X6_.noalias() = X4_*X2_;
+          tmp_ = b13[13]*X6_ + b13[11]*X4_ + b13[9]*X2_;
+          V_.noalias() = X6_*tmp_;
+          V_ += b13[7]*X6_ + b13[5]*X4_ + b13[3]*X2_;
+          V_.diagonal().array() += b13[1];
+          U_.noalias() = Xs_*V_;
+          tmp_ = b13[12]*X6_ + b13[10]*X4_ + b13[8]*X2_;
+          V_.noalias() = X6_*tmp_;
+          V_ += b13[6]*X6_ + b13[4]*X4_ + b13[2]*X2_;
+          V_.diagonal().array() += b13[0];
+        }
+        // E = (V-U)^-1 (V+U)
+        tmp_ = V_ - U_;
+        Eigen::PartialPivLU<Matrix> lu(tmp_);
+        tmp_ = V_ + U_;
+        E = lu.solve(tmp_);
+        for(int i=0; i<squarings_; ++i)
+        {
+          tmp_.noalias() = E*E;
+          E = tmp_;
+        }
+      }
+
+      /**
+       * number of squarings used by the last call to compute
+       */
+      int getSquarings() const { return squarings_; }
+
+    protected:
+      /**
+       * Pade approximant of degree m<=9, X2_ must contain X*X
+       */
+      void padeLowDegree(const Matrix &X, const double *b, int m)
+      {
+        V_.setZero(); tmp_.setZero();
+        V_.diagonal().array() += b[0];
+        tmp_.diagonal().array() += b[1];
+        Xk_.setIdentity();
+        for(int k=2; k<=m; k+=2)
+        {
+          X4_.noalias() = Xk_*X2_;
+          Xk_ = X4_;
+          V_ += b[k]*Xk_;
+          tmp_ += b[k+1]*Xk_;
+        }
+        U_.noalias() = X*tmp_;
+      }
+
+      Matrix X2_, X4_, X6_, Xs_, Xk_, U_, V_, tmp_;
+      int squarings_;
+  }; // class PadeMatrixExponential
+
+
+  /**
+   * Fixed-size integrator of the linear dynamical system dx/dt = A x + a, x(0) = x0, of size N.
+   * Over [0, T] it computes x(T), int_0^T x(t) dt and int_0^T int_0^t x(s) ds dt from the
+   * exponential of the augmented (N+3)x(N+3) matrix
+   *    M = [A, W; 0, J],    W = [a, x0, 0],    J = [0 1 0; 0 0 1; 0 0 0]
+   * whose top-right block is [int_0^T e^{sA} ds a, int x, int int x], while the top-left block is e^{TA}.
+   * All matrices have compile-time sizes, so the products are unrolled by Eigen and nothing is
+   * allocated on the heap. N must be a fixed size (expokit::LDSUtility covers the dynamic case).
+   */
+  template<int N>
+  class LDSKernel
+  {
+    public:
+      enum { NA = N+3 };
+      typedef Eigen::Matrix<double, NA, NA> AugMatrix;
+
+      EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+      /**
+       * xT, intx and int2x must have size N
+       */
+      void compute(const Eigen::Ref<const Eigen::MatrixXd> &A, const Eigen::Ref<const Eigen::VectorXd> &a,
+                   const Eigen::Ref<const Eigen::VectorXd> &x0, double T,
+                   Eigen::Ref<Eigen::VectorXd> xT, Eigen::Ref<Eigen::VectorXd> intx, Eigen::Ref<Eigen::VectorXd> int2x)
+      {
+        // a and x0 are scaled so that they do not dominate the norm of M (the result is linear in W)
+        const double normA = A.cwiseAbs().colwise().sum().maxCoeff();
+        const double normW = std::max(a.lpNorm<1>(), x0.lpNorm<1>());
+        const double c = normW > std::max(normA, 1.0) ? normW/std::max(normA, 1.0) : 1.0;
+
+        M_.setZero();
+        M_.template topLeftCorner<N,N>() = T*A;
+        M_.template block<N,1>(0, N)   = (T/c)*a;
+        M_.template block<N,1>(0, N+1) = (T/c)*x0;
+        M_(N, N+1) = T;
+        M_(N+1, N+2) = T;
+        expm_.compute(M_, E_);
+
+        xT.noalias() = E_.template topLeftCorner<N,N>() * x0;
+        xT += c * E_.template block<N,1>(0, N);
+        intx  = c * E_.template block<N,1>(0, N+1);
+        int2x = c * E_.template block<N,1>(0, N+2);
+      }
+
+      /**
+       * number of squarings used by the last call to compute
+       */
+      int getSquarings() const { return expm_.getSquarings(); }
+
+    protected:
+      AugMatrix M_, E_;
+      PadeMatrixExponential<NA> expm_;
+  }; // class LDSKernel
+
+} // namespace consim
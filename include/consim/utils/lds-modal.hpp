@@ -0,0 +1,97 @@
+
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Eigenvalues>
+#include <Eigen/StdVector>
+
+#include "consim/utils/lds-kernel.hpp"
+#include "consim/utils/view-arena.hpp"
+
+namespace consim
+{
+
+  /**
+   * Integrates the contact LDS of the exponential simulator
+   *    d/dt [p; v] = [0, I; -Y K, -Y B] [p; v] + [a_p; a_v]
+   * with Y symmetric (the Delassus matrix Upsilon) and K, B diagonal, exploiting its structure. 
+   * If B = beta*K (same damping ratio for all the contact directions) the change of coordinates
+   * y = Q^T K^(1/2) p, with K^(1/2) Y K^(1/2) = Q L Q^T, decouples the system into n independent 
+   * 2x2 systems d/dt [y_i; w_i] = [0, 1; -l_i, -beta*l_i] [y_i; w_i] + a_i.
+   * When A changes, the eigendecomposition of an nxn symmetric matrix replaces the dense exponential 
+   * of the 2nx2n matrix A; afterwards every integration takes two nxn matrix products with thin 
+   * matrices, plus O(n) work for the modes.
+   */
+  class LDSModal
+  {
+    public:
+      typedef ViewArena::MatrixView MatrixView;
+      typedef ViewArena::VectorView VectorView;
+
+      LDSModal();
+
+      /**
+       * sets the size of the system (n positions, 2n states); memory is allocated only 
+       * if n exceeds the reserved capacity
+       */
+      void resize(int n);
+      /**
+       * preallocates memory for systems up to n_max positions
+       */
+      void reserve(int n_max);
+
+      /**
+       * computes the modes and their integral operators over [0, T].
+       * Returns false (and the modes cannot be used) if B is not proportional to K.
+       * Eigen's eigensolver allocates a small workspace here, while apply never allocates.
+       */
+      bool compute(const Eigen::Ref<const Eigen::MatrixXd> &Y, const Eigen::Ref<const Eigen::VectorXd> &K,
+                   const Eigen::Ref<const Eigen::VectorXd> &B, double T);
+
+      /**
+       * a, x0, xT, intx and int2x have size 2n
+       */
+      void apply(const Eigen::Ref<const Eigen::VectorXd> &a, const Eigen::Ref<const Eigen::VectorXd> &x0,
+                 Eigen::Ref<Eigen::VectorXd> xT, Eigen::Ref<Eigen::VectorXd> intx, Eigen::Ref<Eigen::VectorXd> int2x);
+
+      int size() const { return n_; }
+
+    protected:
+      /*!< [E, F1, F2, F3] of a mode, see LDSIntegralOperators */
+      typedef Eigen::Matrix<double, 2, 8> ModeOperators;
+      typedef Eigen::Matrix<double, 8, 8> ModeMatrix;
+
+      void bindViews(int n);
+
+      int n_;
+      double beta_;
+      ViewArena arena_;
+      VectorView sqrtK_;
+      MatrixView S_;                                      /*!< K^(1/2) Y K^(1/2) */
+      Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eig_;
+      std::vector<ModeOperators, Eigen::aligned_allocator<ModeOperators> > modes_;
+      PadeMatrixExponential<8> expm_;
+      ModeMatrix Mmode_, Emode_;
+      MatrixView G_;   /*!< n x 4 inputs [p0, v0, a_p, a_v] in scaled coordinates */
+      MatrixView H_;   /*!< n x 4 inputs in modal coordinates */
+      MatrixView R_;   /*!< n x 6 outputs [x(T), int x, int int x] in modal coordinates */
+      MatrixView O_;   /*!< n x 6 outputs in scaled coordinates */
+  }; // class LDSModal
+
+} // namespace consim
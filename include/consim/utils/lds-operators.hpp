@@ -0,0 +1,74 @@
+
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include <Eigen/Core>
+
+#include "consim/utils/view-arena.hpp"
+
+namespace consim
+{
+
+  /**
+   * Operators that integrate the linear dynamical system dx/dt = A x + a over [0, T] for any a and x0:
+   *    x(T)           = E x0  + F1 a
+   *    int x          = F1 x0 + F2 a
+   *    int int x      = F2 x0 + F3 a
+   * with E = e^{TA}, F1 = int_0^T e^{sA} ds, F2 = int_0^T (T-s) e^{sA} ds, F3 = int_0^T (T-s)^2/2 e^{sA} ds.
+   * Computing them costs more than integrating a single LDS, but once computed every integration 
+   * takes only 6 matrix-vector products, so they pay off when A stays the same for several steps.
+   */
+  class LDSIntegralOperators
+  {
+    public:
+      typedef ViewArena::MatrixView MatrixView;
+
+      LDSIntegralOperators();
+
+      /**
+       * sets the size of the system; memory is allocated only if n exceeds the reserved capacity
+       */
+      void resize(int n);
+      /**
+       * preallocates memory for systems up to size n_max
+       */
+      void reserve(int n_max);
+
+      /**
+       * computes E, F1, F2 and F3 with a Taylor expansion on [0, T/2^s] followed by s doublings 
+       * of the time interval
+       */
+      void compute(const Eigen::Ref<const Eigen::MatrixXd> &A, double T);
+
+      void apply(const Eigen::Ref<const Eigen::VectorXd> &a, const Eigen::Ref<const Eigen::VectorXd> &x0,
+                 Eigen::Ref<Eigen::VectorXd> xT, Eigen::Ref<Eigen::VectorXd> intx, Eigen::Ref<Eigen::VectorXd> int2x) const;
+
+      int size() const { return n_; }
+      int getSquarings() const { return squarings_; }
+      const MatrixView &getExp() const { return E_; }
+
+    protected:
+      void bindViews(int n);
+
+      int n_;
+      int squarings_;
+      ViewArena arena_;
+      MatrixView E_, F1_, F2_, F3_;
+      MatrixView X_, term_, tmp_;
+  }; // class LDSIntegralOperators
+
+} // namespace consim
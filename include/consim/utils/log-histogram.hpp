@@ -0,0 +1,122 @@
+
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace consim
+{
+
+  /**
+   * Fixed-bucket log-linear histogram of non-negative integers (e.g. nanoseconds or clock ticks), 
+   * in the spirit of HdrHistogram: every power of two [2^k, 2^(k+1)) is split in 2^SubBits linear 
+   * buckets, so the relative error of a percentile is below 2^-SubBits, and values below 2^SubBits
+   * are counted exactly. Values >= 2^MaxBits are counted in the last bucket.
+   * The counts are a fixed-size array, so recording never allocates. The static helpers allow 
+   * to keep the counts elsewhere (e.g. in atomic counters).
+   */
+  template<int SubBits=3, int MaxBits=40>
+  class LogHistogram
+  {
+    public:
+      enum { SUB_BUCKETS = 1<<SubBits,
+             N_BUCKETS = (MaxBits-SubBits+1)*SUB_BUCKETS };
+
+      LogHistogram() { reset(); }
+
+      void reset()
+      {
+        std::memset(counts_, 0, sizeof(counts_));
+        total_ = 0;
+      }
+
+      void record(uint64_t value)
+      {
+        ++counts_[index(value)];
+        ++total_;
+      }
+
+      uint64_t getCount() const { return total_; }
+
+      /**
+       * value below which p percent of the recorded values lie (0 if nothing was recorded)
+       */
+      uint64_t getPercentile(double p) const { return percentile(counts_, total_, p); }
+
+      const uint64_t *getCounts() const { return counts_; }
+
+      /**
+       * bucket containing value
+       */
+      static int index(uint64_t value)
+      {
+        if(value < (uint64_t) 2*SUB_BUCKETS)
+          return (int) value;
+        const int msb = 63 - __builtin_clzll(value);
+        if(msb >= MaxBits)
+          return N_BUCKETS-1;
+        const int shift = msb - SubBits;
+        return (shift+1)*SUB_BUCKETS + (int) ((value >> shift) - SUB_BUCKETS);
+      }
+
+      /**
+       * smallest and largest value counted in bucket i
+       */
+      static uint64_t lowerBound(int i)
+      {
+        if(i < 2*SUB_BUCKETS)
+          return i;
+        const int shift = i/SUB_BUCKETS - 1;
+        return (uint64_t) (SUB_BUCKETS + i%SUB_BUCKETS) << shift;
+      }
+      static uint64_t upperBound(int i)
+      {
+        if(i < 2*SUB_BUCKETS)
+          return i;
+        const int shift = i/SUB_BUCKETS - 1;
+        return ((uint64_t) (SUB_BUCKETS + i%SUB_BUCKETS + 1) << shift) - 1;
+      }
+
+      /**
+       * percentile of the N_BUCKETS counts, whose sum is total, as the middle of the bucket 
+       * containing the value of rank ceil(p/100*total)
+       */
+      static uint64_t percentile(const uint64_t *counts, uint64_t total, double p)
+      {
+        if(total==0)
+          return 0;
+        uint64_t rank = (uint64_t) std::ceil(p*1e-2*total);
+        if(rank < 1) rank = 1;
+        if(rank > total) rank = total;
+        uint64_t cumulative = 0;
+        for(int i=0; i<N_BUCKETS; ++i){
+          cumulative += counts[i];
+          if(cumulative >= rank)
+            return lowerBound(i) + (upperBound(i) - lowerBound(i))/2;
+        }
+        return upperBound(N_BUCKETS-1);
+      }
+
+    protected:
+      uint64_t counts_[N_BUCKETS];
+      uint64_t total_;
+  }; // class LogHistogram
+
+} // namespace consim
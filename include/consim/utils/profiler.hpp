@@ -0,0 +1,298 @@
+
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "consim/utils/log-histogram.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+/**
+ * Profiling probes, compiled only if CONSIM_PROFILING is defined (CMake option CONSIM_PROFILING).
+ * Every call site registers its name once (function-local static), afterwards starting and 
+ * stopping a probe only reads the clock and updates the accumulators of the calling thread.
+ * CONSIM_PROFILER_SCOPE starts a probe that is stopped at the end of the enclosing scope, also 
+ * when an exception is thrown: stopping it also discards the probes started after it that are 
+ * still running, so a throw below an outermost scoped probe does not leak levels of the stack.
+ */
+#ifdef CONSIM_PROFILING
+#define CONSIM_START_PROFILER(name) do { static const int consim_probe_id = consim::Profiler::registerProbe(name); \
+                                         consim::Profiler::start(consim_probe_id); } while(0)
+#define CONSIM_STOP_PROFILER(name) do { static const int consim_probe_id = consim::Profiler::registerProbe(name); \
+                                        consim::Profiler::stop(consim_probe_id); } while(0)
+#define CONSIM_PROFILER_SCOPE(name) CONSIM_PROFILER_SCOPE_AT_LINE(name, __LINE__)
+#define CONSIM_PROFILER_SCOPE_AT_LINE(name, line) CONSIM_PROFILER_SCOPE_IMPL(name, line)
+#define CONSIM_PROFILER_SCOPE_IMPL(name, line) \
+  static const int consim_scope_probe_id_##line = consim::Profiler::registerProbe(name); \
+  const consim::Profiler::Scope consim_profiler_scope_##line(consim_scope_probe_id_##line)
+#else
+#define CONSIM_START_PROFILER(name) do {} while(0)
+#define CONSIM_STOP_PROFILER(name) do {} while(0)
+#define CONSIM_PROFILER_SCOPE(name) do {} while(0)
+#endif
+
+namespace consim
+{
+
+  /**
+   * Low-overhead hierarchical profiler. 
+   * Probes are identified by integer ids, obtained once per name with registerProbe.
+   * Times are measured with the time stamp counter on x86 (assumed invariant, converted to seconds 
+   * with a calibration against std::chrono::steady_clock) and with steady_clock elsewhere.
+   * Every thread accumulates its own statistics without locks (only the first probe of a thread 
+   * registers it, under a mutex); the getters aggregate the statistics of all the threads.
+   * When a thread exits its slot is returned to the registry, statistics included, and reused by 
+   * the next thread that registers, so that thread pools can be recreated without leaking memory.
+   * Probes can be nested: each thread keeps a stack of the running probes, and the parent of a 
+   * probe is the probe that was running when it was started for the first time.
+   * The durations of every probe are also counted in a log-scale histogram (Histogram), from 
+   * which the percentiles are computed with a relative error below 1/Histogram::SUB_BUCKETS.
+   * Optionally (startTrace) every thread also records its begin/end events in a bounded ring 
+   * buffer, which can be dumped as a Chrome trace (chrome://tracing, ui.perfetto.dev).
+   */
+  class Profiler
+  {
+    public:
+      enum { MAX_PROBES = 256,   /*!< maximum number of distinct probe names */
+             MAX_DEPTH = 32 };   /*!< maximum nesting depth, deeper probes are ignored */
+
+      typedef LogHistogram<> Histogram;   /*!< histogram of the durations in clock ticks */
+
+      /**
+       * returns the id of the probe with the given name, registering it if needed (-1 if there 
+       * are already MAX_PROBES probes)
+       */
+      static int registerProbe(const char *name);
+      /**
+       * returns the id of the probe with the given name, -1 if it does not exist
+       */
+      static int findProbe(const std::string &name);
+      /**
+       * names of all the registered probes, in order of registration
+       */
+      static std::vector<std::string> getProbeNames();
+
+      static inline void start(int id);
+      /**
+       * stops the innermost running instance of the probe, also if the profiler has been 
+       * disabled in the meantime (the measurement is then discarded)
+       */
+      static inline void stop(int id);
+
+      /** starts a probe and stops it when destroyed, see CONSIM_PROFILER_SCOPE */
+      class Scope
+      {
+        public:
+          explicit Scope(int id): id_(id) { start(id_); }
+          ~Scope() { stop(id_); }
+        private:
+          Scope(const Scope &);
+          Scope &operator=(const Scope &);
+          const int id_;
+      };
+
+      /**
+       * enables/disables the recording of all the probes at runtime (enabled by default)
+       */
+      static void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+      static bool isEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+      /**
+       * resets the statistics of all the probes of all the threads
+       */
+      static void resetAll();
+
+      /** statistics of a probe over all the threads, in seconds (0 if the probe never stopped) */
+      static double getTotalTime(const std::string &name);
+      static double getAverageTime(const std::string &name);
+      static double getMinTime(const std::string &name);
+      static double getMaxTime(const std::string &name);
+      static uint64_t getCount(const std::string &name);
+      /** duration below which p percent (e.g. 99.9) of the measurements of a probe lie, in seconds */
+      static double getPercentileTime(const std::string &name, double p);
+
+      /**
+       * prints the statistics of all the probes, children indented below their parent
+       */
+      static void report(int precision=2, std::ostream &output=std::cout);
+
+      /**
+       * starts recording the begin/end events of all the threads, keeping the last 
+       * events_per_thread events of every thread (the previous events are discarded).
+       * The buffers are allocated here, so it should be called while no probe is running.
+       */
+      static void startTrace(std::size_t events_per_thread=65536);
+      static void stopTrace();
+      static bool isTracing() { return tracing_.load(std::memory_order_relaxed); }
+
+      /**
+       * writes the recorded events in the Chrome trace event format (JSON), times in us from startTrace.
+       * It should be called after stopTrace, or while no probe is running.
+       */
+      static void writeTrace(std::ostream &output);
+      static void writeTrace(const std::string &filename);
+
+      static inline uint64_t now();
+      static double secondsPerTick();
+
+    private:
+      struct ProbeStats
+      {
+        std::atomic<uint64_t> total;
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> min;
+        std::atomic<uint64_t> max;
+      };
+
+      struct TraceEvent
+      {
+        uint64_t time;
+        int id;
+        char phase;   /*!< 'B' or 'E' */
+      };
+
+      struct ThreadData
+      {
+        ThreadData(int index);
+        ProbeStats stats[MAX_PROBES];
+        std::atomic<uint32_t> histograms[MAX_PROBES][Histogram::N_BUCKETS];
+        int stack_ids[MAX_DEPTH];
+        uint64_t stack_start[MAX_DEPTH];
+        int depth;
+        const int index;                          /*!< position in the registry, used as tid in the trace */
+        bool in_use;                              /*!< false once the owner thread exited, protected by the registry mutex */
+        std::unique_ptr<TraceEvent[]> trace;      /*!< ring buffer of the events */
+        std::size_t trace_capacity;
+        std::atomic<uint64_t> trace_head;         /*!< number of events recorded since startTrace */
+      };
+
+      struct Totals
+      {
+        uint64_t total, count, min, max;
+      };
+
+      static ThreadData &threadData();
+      static ThreadData *registerThread();
+      /** returns the slot of the calling thread to the registry when the thread exits */
+      struct ThreadReleaser
+      {
+        ~ThreadReleaser();
+      };
+      /** statistics of all the threads that used a probe, kept after the threads exit and reused by new threads */
+      static std::vector<std::unique_ptr<ThreadData> > &threadRegistry();
+      static Totals aggregate(int id);
+      static void reportProbe(int id, int level, int precision, std::ostream &output);
+      static inline void recordEvent(ThreadData &td, int id, char phase, uint64_t time);
+
+      static std::atomic<bool> enabled_;
+      static std::atomic<bool> tracing_;
+      static std::size_t trace_capacity_;
+      static uint64_t trace_origin_;
+      static std::atomic<int> parents_[MAX_PROBES];
+      static thread_local ThreadData *thread_data_;
+  }; // class Profiler
+
+
+  inline uint64_t Profiler::now()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+  }
+
+
+  inline Profiler::ThreadData &Profiler::threadData()
+  {
+    if(thread_data_==NULL)
+      thread_data_ = registerThread();
+    return *thread_data_;
+  }
+
+
+  inline void Profiler::recordEvent(ThreadData &td, int id, char phase, uint64_t time)
+  {
+    if(!isTracing() || td.trace_capacity==0) return;
+    const uint64_t head = td.trace_head.load(std::memory_order_relaxed);
+    TraceEvent &e = td.trace[head % td.trace_capacity];
+    e.time = time;
+    e.id = id;
+    e.phase = phase;
+    td.trace_head.store(head+1, std::memory_order_release);
+  }
+
+
+  inline void Profiler::start(int id)
+  {
+    if(id<0 || !isEnabled()) return;
+    ThreadData &td = threadData();
+    if(td.depth>=MAX_DEPTH) return;
+    if(parents_[id].load(std::memory_order_relaxed)==-2){
+      int unset = -2;
+      parents_[id].compare_exchange_strong(unset, td.depth>0 ? td.stack_ids[td.depth-1] : -1);
+    }
+    td.stack_ids[td.depth] = id;
+    td.stack_start[td.depth] = now();
+    recordEvent(td, id, 'B', td.stack_start[td.depth]);
+    ++td.depth;
+  }
+
+
+  inline void Profiler::stop(int id)
+  {
+    // a probe started before setEnabled(false) must still be popped, so the stack is checked 
+    // whenever the thread has one
+    if(id<0 || thread_data_==NULL) return;
+    const uint64_t end = now();
+    ThreadData &td = *thread_data_;
+    // the probes are usually stopped in reverse order, otherwise the ones above are discarded
+    int k = td.depth-1;
+    while(k>=0 && td.stack_ids[k]!=id)
+      --k;
+    if(k<0) return;
+    if(isTracing())
+      for(int j=td.depth-1; j>=k; --j)
+        recordEvent(td, td.stack_ids[j], 'E', end);
+    const uint64_t lapse = end - td.stack_start[k];
+    td.depth = k;
+    if(!isEnabled()) return;
+    // only this thread writes its statistics, relaxed atomics just make concurrent reads safe
+    ProbeStats &s = td.stats[id];
+    s.total.store(s.total.load(std::memory_order_relaxed) + lapse, std::memory_order_relaxed);
+    s.count.store(s.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if(lapse < s.min.load(std::memory_order_relaxed))
+      s.min.store(lapse, std::memory_order_relaxed);
+    if(lapse > s.max.load(std::memory_order_relaxed))
+      s.max.store(lapse, std::memory_order_relaxed);
+    std::atomic<uint32_t> &bucket = td.histograms[id][Histogram::index(lapse)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+} // namespace consim
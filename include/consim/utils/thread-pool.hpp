@@ -0,0 +1,89 @@
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace consim
+{
+
+  /**
+   * Fixed-size pool of worker threads executing parallel for loops.
+   * Every parallelFor splits the index range in one contiguous chunk per worker;
+   * a worker that exhausts its own chunk steals the remaining indices of the others.
+   * The calling thread takes part in the work as worker 0, so a pool with one thread
+   * does not spawn any thread at all.
+   */
+  class ThreadPool
+  {
+    public:
+      typedef std::function<void(int index, int worker)> Task;
+
+      /**
+       * n_threads <= 0 selects the number of hardware threads.
+       * If pin_threads is true (Linux only) the spawned worker k is pinned to core k.
+       */
+      explicit ThreadPool(int n_threads=0, bool pin_threads=true);
+      ~ThreadPool();
+
+      ThreadPool(const ThreadPool &) = delete;
+      ThreadPool &operator=(const ThreadPool &) = delete;
+
+      int getNumberOfThreads() const {return n_threads_;};
+
+      /**
+       * Calls task(i, worker) for every i in [0, n) and blocks until all calls returned.
+       * Each index is processed exactly once, by an unspecified worker.
+       * If some calls throw, the first exception is rethrown in the calling thread.
+       */
+      void parallelFor(int n, const Task &task);
+
+    private:
+      /** Index range owned by one worker, padded to avoid false sharing */
+      struct WorkRange
+      {
+        std::atomic<int> next;
+        int end;
+        char padding_[64 - sizeof(std::atomic<int>) - sizeof(int)];
+      };
+
+      void workerLoop(int worker);
+      void runWorker(int worker);
+      static void pinCurrentThread(int core);
+
+      const int n_threads_;
+      std::vector<std::thread> threads_;
+      std::unique_ptr<WorkRange[]> ranges_;
+
+      std::mutex mutex_;
+      std::condition_variable start_cv_;
+      std::condition_variable done_cv_;
+      unsigned long generation_ = 0;  /*!< incremented at every parallelFor to wake up the workers */
+      int busy_workers_ = 0;          /*!< workers that did not complete the current parallelFor yet */
+      bool stop_ = false;
+      const Task *task_ = nullptr;
+      std::exception_ptr error_;      /*!< first exception thrown by the current task */
+  }; // class ThreadPool
+
+} // namespace consim
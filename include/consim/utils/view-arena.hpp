@@ -0,0 +1,79 @@
+
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+#pragma once
+
+#include <new>
+#include <stdexcept>
+#include <Eigen/Core>
+
+namespace consim
+{
+
+  /**
+   * Contiguous buffer of doubles on which Eigen::Map views of varying size are bound, so that 
+   * buffers depending on the number of active contacts can be resized without allocating memory,
+   * once enough capacity has been reserved. Views are bound in sequence after a call to start(): 
+   * a first pass with measure=true only computes the required size, reserve() then grows 
+   * the buffer if needed, and a second pass binds the views.
+   */
+  class ViewArena
+  {
+    public:
+      typedef Eigen::Map<Eigen::MatrixXd> MatrixView;
+      typedef Eigen::Map<Eigen::VectorXd> VectorView;
+
+      ViewArena(): size_(0), measuring_(false) {}
+
+      ViewArena(const ViewArena &) = delete;
+      ViewArena &operator=(const ViewArena &) = delete;
+
+      /**
+       * starts a new binding pass, if measure is true the views are bound to NULL
+       */
+      void start(bool measure=false) { size_ = 0; measuring_ = measure; }
+
+      /**
+       * grows the buffer (only if needed) to the size of the last pass
+       */
+      void reserve() { if(size_ > buffer_.size()) buffer_.resize(size_); }
+
+      void bind(MatrixView &m, Eigen::Index rows, Eigen::Index cols) { new (&m) MatrixView(next(rows*cols), rows, cols); }
+      void bind(VectorView &v, Eigen::Index size) { new (&v) VectorView(next(size), size); }
+
+      /**
+       * sets to zero all the views bound in the current pass
+       */
+      void setZero() { buffer_.head(size_).setZero(); }
+
+      Eigen::Index capacity() const { return buffer_.size(); }
+
+    private:
+      double *next(Eigen::Index n)
+      {
+        double *ptr = measuring_ ? NULL : buffer_.data() + size_;
+        size_ += n;
+        if(!measuring_ && size_ > buffer_.size())
+          throw std::runtime_error("ViewArena capacity exceeded, reserve() must be called first");
+        return ptr;
+      }
+
+      Eigen::VectorXd buffer_;
+      Eigen::Index size_;     /*!< size used by the current pass */
+      bool measuring_;
+  }; // class ViewArena
+
+} // namespace consim
@@ -20,4 +20,15 @@ class LinearFeedbackController:
         diff = state_diff(self.robot, xact, self.refX[self.i])
         u = self.refU[self.i] + self.feedBack[self.i].dot(diff)        
         self.i += 1
-        return np.concatenate((np.zeros(6),u))
\ No newline at end of file
+        return np.concatenate((np.zeros(6),u))
+
+    def rollout(self, simu, N):
+        ''' Simulate N control steps in C++ (without holding the GIL) applying the same 
+            feedback law of compute_control. Returns q (nq, N+1), v (nv, N+1) and 
+            f (3, nc, N+1), laid out as in simu_cpp_common.run_simulation.
+        '''
+        nu = self.refU.shape[1]
+        K = np.ascontiguousarray(self.feedBack[self.i:self.i+N]).reshape((N*nu, -1))
+        q, v, f = simu.rollout(self.refU[self.i:self.i+N], K, self.refX[self.i:self.i+N])
+        self.i += N
+        return q, v, f.reshape((-1, 3, N+1)).transpose((1, 0, 2))
@@ -291,6 +291,9 @@ def run_simulation(conf, dt, N, robot, controller, q0, v0, simu_params, ground_t
     try:
         controller.reset(q0, v0, conf.T_pre)
         consim.stop_watch_reset_all()
+        # read-only views of the simulator state: no new array is allocated at every step
+        q_view, v_view = simu.get_q_view(), simu.get_v_view()
+        f_view = simu.get_contact_forces_view()
         time_start = time.time()
         for i in range(0, N):
 #            robot.display(results.q[:,i])
@@ -310,8 +313,8 @@ def run_simulation(conf, dt, N, robot, controller, q0, v0, simu_params, ground_t
             simu.step(results.u[:,i])
 #            time.sleep(5)
                 
-            results.q[:,i+1] = simu.get_q()
-            results.v[:,i+1] = simu.get_v()
+            results.q[:,i+1] = q_view
+            results.v[:,i+1] = v_view
             results.com_pos[:,i+1] = robot.com(results.q[:,i+1])
 #            results.com_vel[:,i+1] = robot.com_vel()
             
@@ -321,8 +324,8 @@ def run_simulation(conf, dt, N, robot, controller, q0, v0, simu_params, ground_t
             elif('implicit-euler' == simu_type):
                 results.avg_iter_num[i] = simu.get_avg_iteration_number()
             
+            results.f[:,:,i+1] = f_view
             for ci, cp in enumerate(cpts):
-                results.f[:,ci,i+1] = cp.f
                 results.f_avg[:,ci,i+1] = cp.f_avg
                 results.f_avg2[:,ci,i+1] = cp.f_avg2
                 results.f_prj[:,ci,i+1] = cp.f_prj
@@ -243,12 +243,17 @@ def run_simulation(conf, dt, N, robot, controller, q0, v0, simu_params, ground_t
             convergence_threshold = simu_params['convergence_threshold']
         except:
             convergence_threshold = 1e-8
+        try:
+            reuse_jacobian = simu_params['reuse_jacobian']
+        except:
+            reuse_jacobian = False
         simu = consim.build_implicit_euler_simulator(dt, ndt, robot.model, robot.data,
                                         conf.K, conf.B, conf.mu)
         simu.set_use_finite_differences_dynamics(use_fin_diff_dyn)
         simu.set_use_finite_differences_nle(use_fin_diff_nle)
         simu.set_use_current_state_as_initial_guess(use_current_state_as_initial_guess)
         simu.set_convergence_threshold(convergence_threshold)
+        simu.set_reuse_jacobian(reuse_jacobian)
     elif('rk4' == simu_type):
         simu = consim.build_rk4_simulator(dt, ndt, robot.model, robot.data,
                                         conf.K, conf.B, conf.mu, forward_dyn_method)
@@ -0,0 +1,77 @@
+''' Measure how the batched simulator scales with the number of threads.
+    N copies of Solo standing on the floor with a joint PD controller are stepped
+    with an increasing number of threads, and the states are compared with the
+    serial run to check that the results do not depend on the scheduling.
+    Finally the robots are dropped from different heights and stepped with all the threads,
+    so that contacts are made and broken (and contact buffers resized) in parallel.
+'''
+import time
+import multiprocessing
+import numpy as np
+
+import consim
+import conf_solo_cpp as conf
+from example_robot_data.robots_loader import loadSolo
+
+N_ENVS = 256
+N_STEPS = 200
+dt = 2e-3
+ndt = 4
+kp = 10.0
+kd = 0.05
+SIMULATORS = ['euler', 'exponential']
+
+robot = loadSolo(False)
+nq, nv = robot.nq, robot.nv
+
+max_threads = multiprocessing.cpu_count()
+n_threads_list = [1]
+while(n_threads_list[-1]*2 <= max_threads):
+    n_threads_list += [2*n_threads_list[-1]]
+if(n_threads_list[-1] != max_threads):
+    n_threads_list += [max_threads]
+
+# each environment starts from a slightly different height
+q0 = np.tile(conf.q0.reshape((nq, 1)), (1, N_ENVS))
+q0[2, :] += np.linspace(0.0, 1e-2, N_ENVS)
+v0 = np.zeros((nv, N_ENVS))
+
+# dropped from up to 10 cm, the feet touch down (and bounce) at different time steps
+q0_drop = q0.copy()
+q0_drop[2, :] += np.linspace(0.0, 0.1, N_ENVS)
+
+def run(simulator_type, n_threads, q_init):
+    ''' Steps the environments from q_init, the PD controller of each environment holds its own initial configuration '''
+    simu = consim.build_batch_simulator(N_ENVS, simulator_type, dt, ndt, robot.model,
+                                        conf.K, conf.B, conf.mu, 3, 0)
+    simu.set_number_of_threads(n_threads)
+    for cf in conf.contact_frames:
+        simu.add_contact_point(cf, robot.model.getFrameId(cf), conf.unilateral_contacts)
+    simu.reset_state(q_init, v0, True)
+    tau = np.zeros((nv, N_ENVS))
+    # read-only views of the batch state: no new array is allocated at every step
+    q, v = simu.get_q_view(), simu.get_v_view()
+    start = time.time()
+    for i in range(N_STEPS):
+        tau[6:, :] = kp*(q_init[7:, :] - q[7:, :]) - kd*v[6:, :]
+        simu.step(tau)
+    elapsed = time.time() - start
+    return elapsed, simu.get_q()
+
+for simulator_type in SIMULATORS:
+    print(("".center(60, '#')))
+    print((" %s, %d environments, %d steps "%(simulator_type, N_ENVS, N_STEPS)).center(60, '#'))
+    serial_time, serial_q = run(simulator_type, 1, q0)
+    for n_threads in n_threads_list:
+        elapsed, q = run(simulator_type, n_threads, q0)
+        print("threads %3d: %8.1f env-steps/s, speed-up %5.2f, efficiency %4.2f, max deviation from serial run %.1e"%(
+              n_threads, N_ENVS*N_STEPS/elapsed, serial_time/elapsed, serial_time/(elapsed*n_threads),
+              np.max(np.abs(q-serial_q))))
+
+for simulator_type in SIMULATORS:
+    print(("".center(60, '#')))
+    print((" %s, %d dropped environments, %d steps "%(simulator_type, N_ENVS, N_STEPS)).center(60, '#'))
+    serial_time, serial_q = run(simulator_type, 1, q0_drop)
+    elapsed, q = run(simulator_type, max_threads, q0_drop)
+    print("threads %3d: speed-up %5.2f, max deviation from serial run %.1e"%(
+          max_threads, serial_time/elapsed, np.max(np.abs(q-serial_q))))
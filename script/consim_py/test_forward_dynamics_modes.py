@@ -0,0 +1,55 @@
+''' Compare the forward dynamics modes of the exponential simulator.
+    Solo stands on the floor with a joint PD controller and is simulated with
+        1: pinocchio.computeMinverse()
+        2: pinocchio.aba() (+ computeMinverse for the contact terms)
+        3: sparse Cholesky factorization, solving one column of Jc^T at a time
+        4: sparse Cholesky factorization shared by dv_bar, Minv*Jc^T and Jc*Minv*Jc^T
+    The computation times of the step and of computeExpLDS are reported, together with
+    the deviation of the final state from mode 3.
+'''
+import time
+import numpy as np
+
+import consim
+import conf_solo_cpp as conf
+from example_robot_data.robots_loader import loadSolo
+
+N_STEPS = 2000
+dt = 2e-3
+ndt = 4
+kp = 10.0
+kd = 0.05
+FD_MODES = [1, 2, 3, 4]
+
+robot = loadSolo(False)
+nq, nv = robot.nq, robot.nv
+q0 = conf.q0.copy()
+v0 = np.zeros(nv)
+
+def run(fd_mode):
+    simu = consim.build_exponential_simulator(dt, ndt, robot.model, robot.data,
+                                    conf.K, conf.B, conf.mu, conf.anchor_slipping_method,
+                                    False, fd_mode, 0, 100, 100, True)
+    for cf in conf.contact_frames:
+        simu.add_contact_point(cf, robot.model.getFrameId(cf), conf.unilateral_contacts)
+    simu.reset_state(q0, v0, True)
+    consim.stop_watch_reset_all()
+    tau = np.zeros(nv)
+    start = time.time()
+    for i in range(N_STEPS):
+        q, v = simu.get_q(), simu.get_v()
+        tau[6:] = kp*(q0[7:] - q[7:]) - kd*v[6:]
+        simu.step(tau)
+    elapsed = time.time() - start
+    exp_lds = consim.stop_watch_get_average_time('exponential_simulator::computeExpLDS')
+    return elapsed, exp_lds, simu.get_q()
+
+print(("".center(60, '#')))
+print((" exponential simulator, %d steps, ndt %d "%(N_STEPS, ndt)).center(60, '#'))
+results = {}
+for fd_mode in FD_MODES:
+    results[fd_mode] = run(fd_mode)
+for fd_mode in FD_MODES:
+    elapsed, exp_lds, q = results[fd_mode]
+    print("FD mode %d: %6.1f us/step, computeExpLDS %6.1f us, max deviation from mode 3 %.1e"%(
+          fd_mode, 1e6*elapsed/N_STEPS, 1e6*exp_lds, np.max(np.abs(q-results[3][2]))))
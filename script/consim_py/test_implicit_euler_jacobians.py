@@ -0,0 +1,66 @@
+''' Check the analytic dynamics Jacobian and the structured Newton solve of the implicit Euler simulator.
+    Solo is simulated on the floor with a joint PD controller, first standing and then sliding 
+    (with an initial horizontal velocity). Every few steps, at the current state, the following are compared:
+        Fx: analytic Jacobian of the dynamics vs finite differences
+        dz: Newton step computed with the analytic Jacobian vs finite differences
+        dz: Newton step solved through the Schur complement vs the dense LU of G
+    The deviations are relative to the largest element of the reference (finite differences or dense LU).
+'''
+import numpy as np
+
+import consim
+import conf_solo_cpp as conf
+from example_robot_data.robots_loader import loadSolo
+
+N_STEPS = 500
+CHECK_EVERY = 10
+dt = 2e-3
+ndt = 1
+kp = 10.0
+kd = 0.05
+SCENARIOS = {'standing': 0.0, 'sliding': 0.5}  # initial horizontal velocity of the base
+
+robot = loadSolo(False)
+nq, nv = robot.nq, robot.nv
+q0 = conf.q0.copy()
+
+def evaluate(simu, tau, fd_dynamics, structured_solve):
+    simu.set_use_finite_differences_dynamics(fd_dynamics)
+    simu.set_use_structured_newton_solve(structured_solve)
+    Fx, dz = simu.evaluate_newton_step(tau)
+    return Fx.copy(), dz.copy()
+
+def rel_dev(x, x_ref):
+    return np.max(np.abs(x - x_ref)) / max(np.max(np.abs(x_ref)), 1e-12)
+
+def run(v_x):
+    simu = consim.build_implicit_euler_simulator(dt, ndt, robot.model, robot.data, conf.K, conf.B, conf.mu)
+    for cf in conf.contact_frames:
+        simu.add_contact_point(cf, robot.model.getFrameId(cf), conf.unilateral_contacts)
+    v0 = np.zeros(nv)
+    v0[0] = v_x
+    simu.reset_state(q0, v0, True)
+    tau = np.zeros(nv)
+    dev = {'Fx': 0.0, 'dz_fd': 0.0, 'dz_schur': 0.0}
+    for i in range(N_STEPS):
+        q, v = simu.get_q(), simu.get_v()
+        tau[6:] = kp*(q0[7:] - q[7:]) - kd*v[6:]
+        if(i % CHECK_EVERY == 0):
+            Fx, dz = evaluate(simu, tau, False, True)
+            Fx_fd, dz_fd = evaluate(simu, tau, True, True)
+            _, dz_lu = evaluate(simu, tau, False, False)
+            dev['Fx'] = max(dev['Fx'], rel_dev(Fx, Fx_fd))
+            dev['dz_fd'] = max(dev['dz_fd'], rel_dev(dz, dz_fd))
+            dev['dz_schur'] = max(dev['dz_schur'], rel_dev(dz, dz_lu))
+            # restore the default options
+            simu.set_use_finite_differences_dynamics(False)
+            simu.set_use_structured_newton_solve(True)
+        simu.step(tau)
+    return dev
+
+print(("".center(60, '#')))
+print((" implicit Euler, Solo, %d steps "%(N_STEPS)).center(60, '#'))
+for name, v_x in SCENARIOS.items():
+    dev = run(v_x)
+    print("%-9s max rel. deviation: Fx analytic vs FD %.1e, dz analytic vs FD %.1e, dz Schur vs dense LU %.1e"%(
+          name, dev['Fx'], dev['dz_fd'], dev['dz_schur']))
@@ -19,6 +19,8 @@
 #include <pinocchio/algorithm/kinematics.hpp>
 #include <pinocchio/algorithm/frames.hpp>
 #include <math.h>
+#include <new>
+#include <stdexcept>
 
 namespace consim {
 
@@ -27,16 +29,98 @@ namespace consim {
 
 
 ContactPoint::ContactPoint(const pinocchio::Model &model, const std::string & name, unsigned int frameId, unsigned int nv, bool isUnilateral):
-        model_(&model), name_(name), frame_id(frameId), unilateral(isUnilateral) {
+        model_(&model), name_(name), frame_id(frameId), unilateral(isUnilateral), 
+        x_anchor(NULL), v_anchor(NULL), x(NULL), v(NULL), world_J_(NULL, 3, 0, Eigen::OuterStride<>(3)), 
+        delta_x(NULL), f(NULL), contactNormal_(NULL) {
           active = false; 
           slipping = false;
-          f.fill(0);
+          ownData_.setZero();
+          ownJ_.resize(3, nv); ownJ_.setZero();
+          bindToOwnStorage();
           predictedF_.fill(0);
           predictedX_.fill(0);
-          world_J_.resize(3, nv); world_J_.setZero();
           full_J_.resize(6, nv); full_J_.setZero();
         }
 
+ContactPoint::ContactPoint(const ContactPoint &other):
+        x_anchor(NULL), v_anchor(NULL), x(NULL), v(NULL), world_J_(NULL, 3, 0, Eigen::OuterStride<>(3)), 
+        delta_x(NULL), f(NULL), contactNormal_(NULL) {
+          copyPointState(other);
+          ownJ_.resize(3, other.world_J_.cols());
+          bindToOwnStorage();
+          x = other.x; v = other.v; 
+          x_anchor = other.x_anchor; v_anchor = other.v_anchor; 
+          delta_x = other.delta_x; contactNormal_ = other.contactNormal_; 
+          f = other.f; world_J_ = other.world_J_;
+        }
+
+ContactPoint &ContactPoint::operator=(const ContactPoint &other){
+  if (this == &other) return *this;
+  copyPointState(other);
+  x = other.x; v = other.v; 
+  x_anchor = other.x_anchor; v_anchor = other.v_anchor; 
+  delta_x = other.delta_x; contactNormal_ = other.contactNormal_; 
+  f = other.f; world_J_ = other.world_J_;
+  return *this;
+}
+
+void ContactPoint::copyPointState(const ContactPoint &other){
+  model_ = other.model_;
+  name_ = other.name_;
+  frame_id = other.frame_id;
+  active = other.active;
+  slipping = other.slipping;
+  unilateral = other.unilateral;
+  optr = other.optr;
+  dJv_ = other.dJv_;
+  full_J_ = other.full_J_;
+  vlocal_ = other.vlocal_;
+  dJvlocal_ = other.dJvlocal_;
+  frameSE3_ = other.frameSE3_;
+  normal = other.normal;
+  normvel = other.normvel;
+  tangent = other.tangent;
+  tanvel = other.tanvel;
+  f_avg = other.f_avg;
+  f_avg2 = other.f_avg2;
+  f_prj = other.f_prj;
+  f_prj2 = other.f_prj2;
+  predictedF_ = other.predictedF_;
+  predictedX_ = other.predictedX_;
+  predictedV_ = other.predictedV_;
+  predictedX0_ = other.predictedX0_;
+  contactTangentA_ = other.contactTangentA_;
+  contactTangentB_ = other.contactTangentB_;
+}
+
+void ContactPoint::copyContactState(const ContactPoint &other){
+  active = other.active;
+  slipping = other.slipping;
+  optr = other.optr;
+  predictedX0_ = other.predictedX0_;
+  contactTangentA_ = other.contactTangentA_;
+  contactTangentB_ = other.contactTangentB_;
+}
+
+void ContactPoint::bindViews(double *x, double *v, double *x_anchor, double *v_anchor, double *delta_x, 
+                             double *normal, double *f, double *J, int nv, int J_stride){
+  // Eigen::Map cannot be reassigned, so the views are rebuilt in place
+  new (&this->x) Vector3dView(x);
+  new (&this->v) Vector3dView(v);
+  new (&this->x_anchor) Vector3dView(x_anchor);
+  new (&this->v_anchor) Vector3dView(v_anchor);
+  new (&this->delta_x) Vector3dView(delta_x);
+  new (&this->contactNormal_) Vector3dView(normal);
+  new (&this->f) Vector3dView(f);
+  new (&this->world_J_) Matrix3XdView(J, 3, nv, Eigen::OuterStride<>(J_stride));
+}
+
+void ContactPoint::bindToOwnStorage(){
+  bindViews(ownData_.col(0).data(), ownData_.col(1).data(), ownData_.col(2).data(), ownData_.col(3).data(), 
+            ownData_.col(4).data(), ownData_.col(5).data(), ownData_.col(6).data(), 
+            ownJ_.data(), (int) ownJ_.cols(), 3);
+}
+
 void ContactPoint::updatePosition(pinocchio::Data &data){
   x = data.oMf[frame_id].translation(); 
 }
@@ -69,6 +153,104 @@ void ContactPoint::projectForceInCone(Eigen::Vector3d &f){
 }
 
 
+// --------------------------------------------------------------------------------------------------------// 
+
+ContactSet::ContactSet(const ContactSet &other){
+  *this = other;
+}
+
+ContactSet::~ContactSet(){
+  clear();
+}
+
+ContactSet &ContactSet::operator=(const ContactSet &other){
+  if (this == &other) return *this;
+  if (size() != other.size()){
+    clear();
+    for (auto &cp : other.points_)
+      add(new ContactPoint(*cp));
+  }
+  else{
+    for (unsigned int i=0; i<size(); ++i)
+      points_[i]->copyPointState(*other.points_[i]);
+  }
+  // same number of points: only J can be reallocated below, if the two sets have different nv
+  const bool rebind = J.cols() != other.J.cols();
+  x = other.x;
+  v = other.v;
+  x_anchor = other.x_anchor;
+  v_anchor = other.v_anchor;
+  delta_x = other.delta_x;
+  contact_normal = other.contact_normal;
+  f = other.f;
+  J = other.J;
+  active_ = other.active_;
+  if (rebind)
+    bindViews();
+  return *this;
+}
+
+void ContactSet::copyStateFrom(const ContactSet &other){
+  if (size() != other.size())
+    throw std::runtime_error("ContactSet::copyStateFrom requires two sets with the same number of points");
+  for (unsigned int i=0; i<size(); ++i)
+    points_[i]->copyContactState(*other.points_[i]);
+  x_anchor = other.x_anchor;
+  v_anchor = other.v_anchor;
+  contact_normal = other.contact_normal;
+  f = other.f;
+  active_ = other.active_;
+}
+
+ContactPoint &ContactSet::add(ContactPoint *cp){
+  const int n = (int) points_.size();
+  const int nv = (int) cp->world_J_.cols();
+  if (n>0 && nv!=J.cols())
+    throw std::runtime_error("All the points of a ContactSet must have the same number of velocities");
+
+  x.conservativeResize(3, n+1);               x.col(n) = cp->x;
+  v.conservativeResize(3, n+1);               v.col(n) = cp->v;
+  x_anchor.conservativeResize(3, n+1);        x_anchor.col(n) = cp->x_anchor;
+  v_anchor.conservativeResize(3, n+1);        v_anchor.col(n) = cp->v_anchor;
+  delta_x.conservativeResize(3, n+1);         delta_x.col(n) = cp->delta_x;
+  contact_normal.conservativeResize(3, n+1);  contact_normal.col(n) = cp->contactNormal_;
+  f.conservativeResize(3, n+1);               f.col(n) = cp->f;
+  J.conservativeResize(3*(n+1), nv);          J.middleRows<3>(3*n) = cp->world_J_;
+
+  points_.push_back(cp);
+  active_.reserve(points_.size());
+  // the blocks have been reallocated, all the views must be rebuilt
+  bindViews();
+  cp->ownJ_.resize(0, 0);
+  return *cp;
+}
+
+int ContactSet::updateActiveIndices(){
+  active_.clear();
+  for (unsigned int i=0; i<points_.size(); ++i){
+    if (points_[i]->active)
+      active_.push_back(i);
+  }
+  return (int) active_.size();
+}
+
+void ContactSet::clear(){
+  for (auto &cp : points_)
+    delete cp;
+  points_.clear();
+  active_.clear();
+  x.resize(3, 0); v.resize(3, 0); x_anchor.resize(3, 0); v_anchor.resize(3, 0); 
+  delta_x.resize(3, 0); contact_normal.resize(3, 0); f.resize(3, 0); J.resize(0, 0);
+}
+
+void ContactSet::bindViews(){
+  for (unsigned int i=0; i<points_.size(); ++i){
+    points_[i]->bindViews(x.col(i).data(), v.col(i).data(), x_anchor.col(i).data(), v_anchor.col(i).data(), 
+                          delta_x.col(i).data(), contact_normal.col(i).data(), f.col(i).data(), 
+                          J.data() + 3*i, (int) J.cols(), (int) J.rows());
+  }
+}
+
 // --------------------------------------------------------------------------------------------------------// 
 
 LinearPenaltyContactModel::LinearPenaltyContactModel(Eigen::Vector3d &stiffness, Eigen::Vector3d &damping, double frictionCoeff){
@@ -91,24 +273,24 @@ void LinearPenaltyContactModel::computeForce(ContactPoint& cp)
   // cp.f = stiffness_.cwiseProduct(cp.delta_x) + damping_.cwiseProduct(cp.v_anchor - cp.v); 
   cp.f = stiffness_.cwiseProduct(cp.delta_x) - damping_.cwiseProduct(cp.v); 
   /*!< force along normal to contact object */ 
-  normalNorm_ = cp.f.dot(cp.contactNormal_);
+  const double normalNorm = cp.f.dot(cp.contactNormal_);
   /*!< unilateral force, no pulling into contact object */ 
-  if (cp.unilateral && normalNorm_<0){
+  if (cp.unilateral && normalNorm<0){
     cp.f.fill(0);
     cp.slipping = false;
     return;
   } 
 
 
-  normalF_ = normalNorm_ * cp.contactNormal_; 
-  tangentF_ = cp.f - normalF_;
-  tangentNorm_ = tangentF_.norm();
+  const Eigen::Vector3d normalF = normalNorm * cp.contactNormal_; 
+  const Eigen::Vector3d tangentF = cp.f - normalF;
+  const double tangentNorm = tangentF.norm();
   
-  if (cp.unilateral && (tangentNorm_ > friction_coeff_*normalNorm_)){
+  if (cp.unilateral && (tangentNorm > friction_coeff_*normalNorm)){
     cp.slipping = true;
-    tangentDir_ = tangentF_/tangentNorm_; 
-    cp.f = normalF_;
-    cp.f += friction_coeff_*normalNorm_*tangentDir_; 
+    const Eigen::Vector3d tangentDir = tangentF/tangentNorm; 
+    cp.f = normalF;
+    cp.f += friction_coeff_*normalNorm*tangentDir; 
     
     // assume anchor point tangent vel is equal to contact point tangent vel
     cp.v_anchor = cp.v - (cp.v.dot(cp.contactNormal_))*cp.contactNormal_;
@@ -125,40 +307,68 @@ void LinearPenaltyContactModel::computeForceNoUpdate(const ContactPoint& cp, Eig
   // cp.f = stiffness_.cwiseProduct(cp.delta_x) + damping_.cwiseProduct(cp.v_anchor - cp.v); 
   f = stiffness_.cwiseProduct(cp.delta_x) - damping_.cwiseProduct(cp.v); 
   /*!< force along normal to contact object */ 
-  normalNorm_ = cp.f.dot(cp.contactNormal_);
+  const double normalNorm = cp.f.dot(cp.contactNormal_);
   /*!< unilateral force, no pulling into contact object */ 
-  if (cp.unilateral && normalNorm_<0){
+  if (cp.unilateral && normalNorm<0){
     f.fill(0);
     return;
   } 
 
-  normalF_ = normalNorm_ * cp.contactNormal_; 
-  tangentF_ = cp.f - normalF_;
-  tangentNorm_ = tangentF_.norm();
+  const Eigen::Vector3d normalF = normalNorm * cp.contactNormal_; 
+  const Eigen::Vector3d tangentF = cp.f - normalF;
+  const double tangentNorm = tangentF.norm();
   
-  if (cp.unilateral && (tangentNorm_ > friction_coeff_*normalNorm_)){
+  if (cp.unilateral && (tangentNorm > friction_coeff_*normalNorm)){
     //cp.slipping = true;
-    tangentDir_ = tangentF_/tangentNorm_; 
-    f = normalF_;
-    f += friction_coeff_*normalNorm_*tangentDir_; 
+    const Eigen::Vector3d tangentDir = tangentF/tangentNorm; 
+    f = normalF;
+    f += friction_coeff_*normalNorm*tangentDir; 
   } 
 }
 
 void LinearPenaltyContactModel::projectForceInCone(Eigen::Vector3d &f, ContactPoint& cp)
 {
   /*!< force along normal to contact object */ 
-  normalNorm_ = f.dot(cp.contactNormal_); 
+  const double normalNorm = f.dot(cp.contactNormal_); 
 
   /*!< unilateral force, no pulling into contact object */ 
-  if (cp.unilateral && normalNorm_<0.0){
+  if (cp.unilateral && normalNorm<0.0){
     f.setZero();
     return;
   } 
-  tangentF_ = f - normalNorm_*cp.contactNormal_;
-  tangentNorm_ = tangentF_.norm();
-  if (cp.unilateral && (tangentNorm_ > friction_coeff_*normalNorm_)){
-    tangentDir_ = tangentF_/tangentNorm_; 
-    f = normalNorm_*cp.contactNormal_ + (friction_coeff_*normalNorm_)*tangentDir_; 
+  const Eigen::Vector3d tangentF = f - normalNorm*cp.contactNormal_;
+  const double tangentNorm = tangentF.norm();
+  if (cp.unilateral && (tangentNorm > friction_coeff_*normalNorm)){
+    const Eigen::Vector3d tangentDir = tangentF/tangentNorm; 
+    f = normalNorm*cp.contactNormal_ + (friction_coeff_*normalNorm)*tangentDir; 
+  }
+}
+
+void LinearPenaltyContactModel::computeForceProjectionJacobian(const ContactPoint& cp, Eigen::Matrix3d &P) const
+{
+  P.setIdentity();
+  if (!cp.unilateral) return;
+
+  const Eigen::Vector3d f = stiffness_.cwiseProduct(cp.delta_x) - damping_.cwiseProduct(cp.v); 
+  const Eigen::Vector3d n = cp.contactNormal_;
+  const double normalNorm = f.dot(n);
+  /*!< released contact, the force is zero around f */ 
+  if (normalNorm<0){
+    P.setZero();
+    return;
+  } 
+  const Eigen::Vector3d tangentF = f - normalNorm*n;
+  const double tangentNorm = tangentF.norm();
+  if (tangentNorm > friction_coeff_*normalNorm){
+    /*!< slipping: f = fn*n + mu*fn*t/|t|, with fn = n^T f and t = (I - n n^T) f */ 
+    const Eigen::Vector3d tangentDir = tangentF/tangentNorm; 
+    P.noalias() = n * n.transpose();
+    P.noalias() += friction_coeff_ * tangentDir * n.transpose();
+    // (I - t t^T)(I - n n^T) = I - n n^T - t t^T because t is orthogonal to n
+    const double c = friction_coeff_*normalNorm/tangentNorm;
+    P.noalias() -= c * n * n.transpose();
+    P.noalias() -= c * tangentDir * tangentDir.transpose();
+    P.diagonal().array() += c;
   }
 }
 
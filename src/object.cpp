@@ -92,17 +92,16 @@ HalfPlaneObject::HalfPlaneObject(const std::string & name, ContactModel& contact
 
   }
 
-void HalfPlaneObject::computeDistance(ContactPoint &cp){
-  distance_ = planeNormal_.transpose()*cp.x;  
-  distance_ += plane_offset_;  
+double HalfPlaneObject::computeDistance(const ContactPoint &cp) const{
+  double distance = planeNormal_.transpose()*cp.x;  
+  distance += plane_offset_;  
+  return distance;
 }
 
 bool HalfPlaneObject::checkCollision(ContactPoint &cp)
 {
   // checks for penetration into the plane 
-  computeDistance(cp);
-  
-  if (distance_ > 0.) {
+  if (computeDistance(cp) > 0.) {
     return false;
   }
 
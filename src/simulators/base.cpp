@@ -54,13 +54,15 @@ whichFD_(whichFD), integration_type_(type) {
   inverseM_.resize(model.nv, model.nv); inverseM_.setZero();
   mDv_.resize(model.nv); mDv_.setZero();
   fkDv_.resize(model_->nv); fkDv_.setZero();
+  allTermsQ_.resize(model.nq); allTermsQ_.setZero();
+  allTermsV_.resize(model.nv); allTermsV_.setZero();
 } 
 
 
 const ContactPoint &AbstractSimulator::addContactPoint(const std::string & name, int frame_id, bool unilateral)
 {
   ContactPoint *cptr = new ContactPoint(*model_, name, frame_id, model_->nv, unilateral);
-	contacts_.push_back(cptr);
+	contacts_.add(cptr);
   nc_ += 1; /*!< total number of defined contact points */ 
   resetflag_ = false; /*!< cannot call Simulator::step() if resetflag is false */ 
   return getContact(name);
@@ -110,6 +112,8 @@ void AbstractSimulator::resetState(const Eigen::VectorXd& q, const Eigen::Vector
       cptr->f.fill(0);
     }
   }
+  statsActiveIndices_.reserve(nc_);
+  reserveContactBuffers();
   computeContactForces();
   for (unsigned int i=0; i<nc_; ++i){
     contacts_[i]->predictedX_ = data_->oMf[contacts_[i]->frame_id].translation(); 
@@ -118,7 +122,43 @@ void AbstractSimulator::resetState(const Eigen::VectorXd& q, const Eigen::Vector
   resetflag_ = true;
 }
 
-void AbstractSimulator::detectContacts(std::vector<ContactPoint *> &contacts)
+void AbstractSimulator::rollout(const Eigen::MatrixXd &tau_ff, const Eigen::MatrixXd &K, const Eigen::MatrixXd &x_ref,
+                                Eigen::MatrixXd &q, Eigen::MatrixXd &v, Eigen::MatrixXd &f)
+{
+  const int T = (int)tau_ff.rows();
+  const int nu = (int)tau_ff.cols();
+  const int nq = model_->nq;
+  const int nv = model_->nv;
+  if(nu > nv)
+    throw std::runtime_error("Rollout feed-forward torques have more columns than nv");
+  if(K.rows()!=T*nu || K.cols()!=2*nv)
+    throw std::runtime_error("Rollout feedback gains must be (T*nu) x 2nv");
+  if(x_ref.rows()!=T || x_ref.cols()!=nq+nv)
+    throw std::runtime_error("Rollout reference states must be T x (nq+nv)");
+
+  q.resize(nq, T+1);
+  v.resize(nv, T+1);
+  f.resize(3*nc_, T+1);
+  rolloutTau_.setZero(nv);
+  rolloutDx_.resize(2*nv);
+  Eigen::VectorXd &tau = rolloutTau_;
+  Eigen::VectorXd &dx = rolloutDx_;
+
+  for (int t=0; t<=T; ++t){
+    if(t>0){
+      pinocchio::difference(*model_, q_, x_ref.row(t-1).head(nq).transpose(), dx.head(nv));
+      dx.tail(nv) = x_ref.row(t-1).tail(nv).transpose() - v_;
+      tau.tail(nu) = tau_ff.row(t-1).transpose();
+      tau.tail(nu).noalias() += K.middleRows((t-1)*nu, nu) * dx;
+      step(tau);
+    }
+    q.col(t) = q_;
+    v.col(t) = v_;
+    f.col(t) = Eigen::Map<const Eigen::VectorXd>(contacts_.f.data(), 3*nc_);
+  }
+}
+
+void AbstractSimulator::detectContacts(ContactSet &contacts)
 {
   contactChange_ = false;  
   newActive_ = detectContacts_imp(*data_, contacts, objects_);
@@ -129,6 +169,24 @@ void AbstractSimulator::detectContacts(std::vector<ContactPoint *> &contacts)
   nactive_ = newActive_;
 }
 
+void AbstractSimulator::startStepStats()
+{
+  stepStats_.reset();
+  stepStats_.active_contacts = nactive_;
+  statsActiveIndices_ = contacts_.getActiveIndices();
+  phaseStart_ = Profiler::now();
+}
+
+void AbstractSimulator::endSubstepStats()
+{
+  stepStats_.substeps += 1;
+  if(contacts_.getActiveIndices()!=statsActiveIndices_){
+    stepStats_.contact_changes += 1;
+    statsActiveIndices_ = contacts_.getActiveIndices();
+  }
+  stepStats_.active_contacts = nactive_;
+}
+
 void AbstractSimulator::setJointFriction(const Eigen::VectorXd& joint_friction)
 {
   joint_friction_flag_= true;
@@ -142,6 +200,7 @@ void AbstractSimulator::forwardDynamics(Eigen::VectorXd &tau, Eigen::VectorXd &d
    *  1: pinocchio::computeMinverse()
    *  2: pinocchio::aba()
    *  3: cholesky decompostion 
+   *  4: same as 3, the factorization is reused by ExponentialSimulator 
    **/  
 
   // if q and v are not specified -> use the current state
@@ -150,10 +209,14 @@ void AbstractSimulator::forwardDynamics(Eigen::VectorXd &tau, Eigen::VectorXd &d
   if(v==NULL)
     v = &v_;
 
+  // M and nle may have already been computed together with the kinematics
+  const bool cached = dynamicsCached(*q, *v);
+
   switch (whichFD_)
       {
         case 1: // slower than ABA
-          pinocchio::nonLinearEffects(*model_, *data_, *q, *v);
+          if(!cached)
+            pinocchio::nonLinearEffects(*model_, *data_, *q, *v);
           mDv_ = tau - data_->nle;
           inverseM_ = pinocchio::computeMinverse(*model_, *data_, *q);
           inverseM_.triangularView<Eigen::StrictlyLower>()
@@ -167,10 +230,13 @@ void AbstractSimulator::forwardDynamics(Eigen::VectorXd &tau, Eigen::VectorXd &d
           break;
           
         case 3: // fast if some results are reused
-          pinocchio::nonLinearEffects(*model_, *data_, *q, *v);
+        case 4:
+          if(!cached){
+            pinocchio::nonLinearEffects(*model_, *data_, *q, *v);
+            pinocchio::crba(*model_, *data_, *q);
+          }
           dv = tau - data_->nle; 
           // Sparse Cholesky factorization
-          pinocchio::crba(*model_, *data_, *q);
           pinocchio::cholesky::decompose(*model_, *data_);
           pinocchio::cholesky::solve(*model_,*data_, dv);
           break;
@@ -180,4 +246,16 @@ void AbstractSimulator::forwardDynamics(Eigen::VectorXd &tau, Eigen::VectorXd &d
       }
 }
 
+void AbstractSimulator::computeKinematicsAndDynamics(const Eigen::VectorXd &q, const Eigen::VectorXd &v)
+{
+  // the joint accelerations are zero, so data_->a only contains the drift used by secondOrderContactKinematics
+  pinocchio::forwardKinematics(*model_, *data_, q, v, fkDv_);
+  pinocchio::crba(*model_, *data_, q);
+  pinocchio::nonLinearEffects(*model_, *data_, q, v);
+  pinocchio::updateFramePlacements(*model_, *data_);
+  allTermsQ_ = q;
+  allTermsV_ = v;
+  all_terms_valid_ = true;
+}
+
 }  // namespace consim 
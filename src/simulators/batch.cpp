@@ -0,0 +1,144 @@
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+
+#include "consim/simulators/batch.hpp"
+
+#include <iostream>
+
+using namespace Eigen;
+
+namespace consim
+{
+
+/**
+ * BatchSimulator Class
+*/
+
+BatchSimulator::BatchSimulator(const pinocchio::Model &model, int n_envs, const SimulatorFactory &factory):
+model_(&model), n_envs_(n_envs)
+{
+  if(n_envs_<=0)
+    throw std::runtime_error("Number of environments must be positive");
+
+  datas_.reserve(n_envs_);
+  simulators_.reserve(n_envs_);
+  tau_.resize(n_envs_, VectorXd::Zero(model.nv));
+  for (int i=0; i<n_envs_; ++i){
+    datas_.push_back(new pinocchio::Data(model));
+    AbstractSimulator *sim = factory(model, *datas_[i]);
+    if(sim==NULL)
+      throw std::runtime_error("Simulator factory returned a NULL simulator");
+    simulators_.push_back(sim);
+  }
+
+  q_.resize(model.nq, n_envs_); q_.setZero();
+  v_.resize(model.nv, n_envs_); v_.setZero();
+  dv_.resize(model.nv, n_envs_); dv_.setZero();
+}
+
+
+BatchSimulator::~BatchSimulator()
+{
+  for (auto &sim : simulators_)
+    delete sim;
+  for (auto &data : datas_)
+    delete data;
+}
+
+
+void BatchSimulator::addContactPoint(const std::string & name, int frame_id, bool unilateral)
+{
+  for (auto &sim : simulators_)
+    sim->addContactPoint(name, frame_id, unilateral);
+}
+
+
+void BatchSimulator::addObject(ContactObject& obj)
+{
+  for (auto &sim : simulators_)
+    sim->addObject(obj);
+}
+
+
+AbstractSimulator &BatchSimulator::getSimulator(int i)
+{
+  if(i<0 || i>=n_envs_)
+    throw std::runtime_error("Environment index out of range "+std::to_string(i));
+  return *simulators_[i];
+}
+
+
+void BatchSimulator::resetState(const Eigen::MatrixXd& q, const Eigen::MatrixXd& dq, bool reset_contact_state)
+{
+  if(q.rows()!=model_->nq || q.cols()!=n_envs_ || dq.rows()!=model_->nv || dq.cols()!=n_envs_)
+    throw std::runtime_error("Batch state has wrong dimensions");
+
+  for (int i=0; i<n_envs_; ++i){
+    simulators_[i]->resetState(q.col(i), dq.col(i), reset_contact_state);
+    q_.col(i) = simulators_[i]->get_q();
+    v_.col(i) = simulators_[i]->get_v();
+    dv_.col(i) = simulators_[i]->get_dv();
+  }
+}
+
+
+void BatchSimulator::setJointFriction(const Eigen::VectorXd& joint_friction)
+{
+  for (auto &sim : simulators_)
+    sim->setJointFriction(joint_friction);
+}
+
+
+void BatchSimulator::step(const Eigen::MatrixXd& tau)
+{
+  if(tau.rows()!=model_->nv || tau.cols()!=n_envs_)
+    throw std::runtime_error("Batch torques have wrong dimensions, expected nv x n_envs");
+
+  for (int i=0; i<n_envs_; ++i)
+    tau_[i] = tau.col(i);
+
+  if(pool_){
+    // Eigen's no-malloc flag is process-wide: it stays true while the environments are stepped in parallel
+    setMallocAllowed(true);
+    pool_->parallelFor(n_envs_, [this](int i, int /*worker*/){
+      ScopedMallocChecksSuspension suspension;
+      stepEnvironment(i);
+    });
+  }
+  else{
+    for (int i=0; i<n_envs_; ++i)
+      stepEnvironment(i);
+  }
+}
+
+
+void BatchSimulator::setNumberOfThreads(int n_threads, bool pin_threads)
+{
+  pool_.reset();
+  if(n_threads!=1)
+    pool_.reset(new ThreadPool(n_threads, pin_threads));
+}
+
+
+void BatchSimulator::stepEnvironment(int i)
+{
+  simulators_[i]->step(tau_[i]);
+  q_.col(i) = simulators_[i]->get_q();
+  v_.col(i) = simulators_[i]->get_v();
+  dv_.col(i) = simulators_[i]->get_dv();
+}
+
+}  // namespace consim
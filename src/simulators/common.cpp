@@ -25,6 +25,7 @@
 #include <pinocchio/algorithm/cholesky.hpp>
 #include <pinocchio/algorithm/jacobian.hpp>
 #include <pinocchio/algorithm/aba-derivatives.hpp>
+#include <pinocchio/multibody/visitor.hpp>
 
 #include "consim/object.hpp"
 #include "consim/contact.hpp"
@@ -37,7 +38,32 @@ using namespace Eigen;
 namespace consim 
 {
 
-int detectContacts_imp(pinocchio::Data &data, std::vector<ContactPoint *> &contacts, std::vector<ContactObject*> &objects)
+namespace
+{
+  thread_local bool malloc_checks_enabled = true;
+}
+
+void setMallocAllowed(bool allowed)
+{
+#ifdef EIGEN_RUNTIME_NO_MALLOC
+  if(malloc_checks_enabled)
+    Eigen::internal::set_is_malloc_allowed(allowed);
+#else
+  (void)allowed;
+#endif
+}
+
+ScopedMallocChecksSuspension::ScopedMallocChecksSuspension(): previous_(malloc_checks_enabled)
+{
+  malloc_checks_enabled = false;
+}
+
+ScopedMallocChecksSuspension::~ScopedMallocChecksSuspension()
+{
+  malloc_checks_enabled = previous_;
+}
+
+int detectContacts_imp(pinocchio::Data &data, ContactSet &contacts, std::vector<ContactObject*> &objects)
 {
   // counter of number of active contacts
   int newActive = 0;
@@ -86,27 +112,63 @@ int detectContacts_imp(pinocchio::Data &data, std::vector<ContactPoint *> &conta
       }
     }
   }
+  contacts.updateActiveIndices();
   return newActive;
 }
 
-int computeContactForces_imp(const pinocchio::Model &model, pinocchio::Data &data, const Eigen::VectorXd &q, 
-                         const Eigen::VectorXd &v, Eigen::VectorXd &tau_f, 
-                         std::vector<ContactPoint*> &contacts, std::vector<ContactObject*> &objects) 
+/**
+ * Same as the forward step of pinocchio::computeJointJacobians, for a single joint
+ */
+struct ContactJacobianStep : public pinocchio::fusion::JointUnaryVisitorBase<ContactJacobianStep>
+{
+  typedef boost::fusion::vector<pinocchio::Data &> ArgsType;
+
+  template<typename JointModel>
+  static void algo(const pinocchio::JointModelBase<JointModel> &jmodel,
+                   pinocchio::JointDataBase<typename JointModel::JointDataDerived> &jdata,
+                   pinocchio::Data &data)
+  {
+    jmodel.jointCols(data.J) = data.oMi[jmodel.id()].act(jdata.S());
+  }
+};
+
+void computeContactJacobians(const pinocchio::Model &model, pinocchio::Data &data, const ContactSet &contacts)
+{
+  const std::vector<int> &active = contacts.getActiveIndices();
+  for(unsigned int k=0; k<active.size(); ++k){
+    const pinocchio::JointIndex joint_id = model.frames[contacts[active[k]]->frame_id].parent;
+    for(pinocchio::JointIndex j=joint_id; j>0; j=model.parents[j]){
+      // stop at the first joint supporting a previous contact (its support has been computed too),
+      // joints are numbered depth-first so the subtree of j is [j, lastChild[j]]
+      bool computed = false;
+      for(unsigned int h=0; h<k && !computed; ++h){
+        const int other = (int) model.frames[contacts[active[h]]->frame_id].parent;
+        computed = other >= (int) j && other <= data.lastChild[j];
+      }
+      if(computed) break;
+      ContactJacobianStep::run(model.joints[j], data.joints[j], ContactJacobianStep::ArgsType(data));
+    }
+  }
+}
+
+int computeContactForces_imp(const pinocchio::Model &model, pinocchio::Data &data, const Eigen::Ref<const Eigen::VectorXd> &q, 
+                         const Eigen::Ref<const Eigen::VectorXd> &v, Eigen::VectorXd &tau_f, 
+                         ContactSet &contacts, std::vector<ContactObject*> &objects) 
 {
   pinocchio::forwardKinematics(model, data, q, v);
-  pinocchio::computeJointJacobians(model, data);
   pinocchio::updateFramePlacements(model, data);
   /*!< loops over all contacts and objects to detect contacts and update contact positions*/
   
   int newActive = detectContacts_imp(data, contacts, objects);
+  computeContactJacobians(model, data, contacts);
   CONSIM_START_PROFILER("compute_contact_forces");
   tau_f.setZero();
-  for (auto &cp : contacts) {
-    if (!cp->active) continue;
+  for (const int i : contacts.getActiveIndices()) {
+    ContactPoint *cp = contacts[i];
     cp->firstOrderContactKinematics(data); /*!<  must be called before computePenetration() it updates cp.v and jacobian*/   
     cp->optr->computePenetration(*cp); 
     cp->optr->contact_model_->computeForce(*cp);
-    tau_f.noalias() += cp->world_J_.transpose() * cp->f; 
+    tau_f.noalias() += contacts.J.middleRows<3>(3*i).transpose() * contacts.f.col(i); 
     // if (contactChange_){
     //     std::cout<<cp->name_<<" p ["<< cp->x.transpose() << "] v ["<< cp->v.transpose() << "] f ["<<  cp->f.transpose() <<"]"<<std::endl; 
     //   }
@@ -59,11 +59,12 @@ void EulerSimulator::step(const Eigen::VectorXd &tau)
   if(!resetflag_){
     throw std::runtime_error("resetState() must be called first !");
   }
-  CONSIM_START_PROFILER("euler_simulator::step");
+  CONSIM_PROFILER_SCOPE("euler_simulator::step");
   assert(tau.size() == model_->nv);
+  startStepStats();
   for (int i = 0; i < n_integration_steps_; i++)
     {
-      Eigen::internal::set_is_malloc_allowed(false);
+      setMallocAllowed(false);
       CONSIM_START_PROFILER("euler_simulator::substep");
       // \brief add input control 
       tau_ += tau;
@@ -73,6 +74,7 @@ void EulerSimulator::step(const Eigen::VectorXd &tau)
       }
       
       forwardDynamics(tau_, dv_); 
+      lapStepPhase(StepStats::DYNAMICS);
     
       CONSIM_START_PROFILER("euler_simulator::integration");
       /*!< integrate twice */ 
@@ -92,15 +94,17 @@ void EulerSimulator::step(const Eigen::VectorXd &tau)
       v_ += dv_ * sub_dt;
       q_ = qnext_;
       CONSIM_STOP_PROFILER("euler_simulator::integration");
+      lapStepPhase(StepStats::INTEGRATION);
       
       // \brief adds contact forces to tau_
       tau_.setZero();
       computeContactForces(); 
-      Eigen::internal::set_is_malloc_allowed(true);
+      lapStepPhase(StepStats::CONTACTS);
+      endSubstepStats();
+      setMallocAllowed(true);
       CONSIM_STOP_PROFILER("euler_simulator::substep");
       elapsedTime_ += sub_dt; 
     }
-  CONSIM_STOP_PROFILER("euler_simulator::step");
 }
 
 }  // namespace consim 
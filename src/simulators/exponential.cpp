@@ -48,8 +48,23 @@ ExponentialSimulator::ExponentialSimulator(const pinocchio::Model &model, pinocc
                                             ldsMaxMatMul_(lds_max_mat_mul),
                                             assumeSlippageContinues_(true),
                                             use_diagonal_matrix_exp_(false),
+                                            use_fixed_size_kernels_(true),
+                                            use_expmv_(false),
+                                            use_modal_exp_(false),
+                                            modal_valid_(false),
+                                            xT_computed_(false),
+                                            allocation_free_(false),
                                             update_A_frequency_(1),
-                                            update_A_counter_(0)
+                                            update_A_counter_(0),
+                                            f_(NULL, 0), Jc_(NULL, 0, 0), p0_(NULL, 0), dp0_(NULL, 0), 
+                                            p_(NULL, 0), dp_(NULL, 0), x0_(NULL, 0), a_(NULL, 0), b_(NULL, 0),
+                                            intxt_(NULL, 0), int2xt_(NULL, 0), xT_(NULL, 0), dJv_(NULL, 0),
+                                            K(NULL, 0), B(NULL, 0), B_copy(NULL, 0), D(NULL, 0, 0), A(NULL, 0, 0),
+                                            MinvJcT_(NULL, 0, 0), UinvJcT_(NULL, 0, 0), Upsilon_(NULL, 0, 0),
+                                            upsilon_patch_pending_(false),
+                                            JcT_(NULL, 0, 0), predictedForce_(NULL, 0), predictedXf_(NULL, 0),
+                                            temp03_(NULL, 0), temp04_(NULL, 0), tempStepMat_(NULL, 0, 0),
+                                            f_avg(NULL, 0), f_avg2(NULL, 0), fpr_(NULL, 0), fpr2_(NULL, 0)
 {
   dvMean_.resize(model_->nv);
   dvMean2_.resize(model_->nv);
@@ -57,17 +72,31 @@ ExponentialSimulator::ExponentialSimulator(const pinocchio::Model &model, pinocc
   dv_bar.resize(model_->nv); dv_bar.setZero();
   temp01_.resize(model_->nv); temp01_.setZero();
   temp02_.resize(model_->nv); temp02_.setZero();
+  sqrtDinv_.resize(model_->nv); sqrtDinv_.setZero();
 
   util_eDtA.setMaxMultiplications(expMaxMatMul_); 
   utilDense_.setMaxMultiplications(ldsMaxMatMul_); 
 }
 
 
+void ExponentialSimulator::setAllocationFree(bool flag)
+{
+  allocation_free_ = flag;
+  // expokit is not resized while the flag is set
+  if(!allocation_free_ && nactive_>0)
+    utilDense_.resize(6 * nactive_);
+}
+
+
 void ExponentialSimulator::step(const Eigen::VectorXd &tau){
-  CONSIM_START_PROFILER("exponential_simulator::step");
   if(!resetflag_){
     throw std::runtime_error("resetState() must be called first !");
   }
+  CONSIM_PROFILER_SCOPE("exponential_simulator::step");
+
+  // data_ may have been used by the caller since the last step 
+  all_terms_valid_ = false;
+  startStepStats();
 
   // \brief add input control 
   tau_ = tau;
@@ -79,7 +108,7 @@ void ExponentialSimulator::step(const Eigen::VectorXd &tau){
   for (int i = 0; i < n_integration_steps_; i++){
     CONSIM_START_PROFILER("exponential_simulator::substep"); 
     if (nactive_> 0){
-      Eigen::internal::set_is_malloc_allowed(false);
+      setMallocAllowed(false);
       
       CONSIM_START_PROFILER("exponential_simulator::computeExpLDS");
       bool update_A = false;
@@ -88,11 +117,12 @@ void ExponentialSimulator::step(const Eigen::VectorXd &tau){
         update_A = true;
         update_A_counter_ = update_A_frequency_;
       }
-      computeExpLDS(update_A);
+      const bool A_changed = computeExpLDS(update_A);
       CONSIM_STOP_PROFILER("exponential_simulator::computeExpLDS");
+      lapStepPhase(StepStats::DYNAMICS);
 
       CONSIM_START_PROFILER("exponential_simulator::computeIntegralsXt");
-      utilDense_.ComputeIntegrals(A, a_, x0_, sub_dt, intxt_, int2xt_);
+      computeIntegralsXt(A_changed);
       CONSIM_STOP_PROFILER("exponential_simulator::computeIntegralsXt");
 
       CONSIM_START_PROFILER("exponential_simulator::checkFrictionCone");
@@ -109,6 +139,7 @@ void ExponentialSimulator::step(const Eigen::VectorXd &tau){
       CONSIM_START_PROFILER("exponential_simulator::noContactsForwardDynamics");
       forwardDynamics(tau_, dvMean_); 
       CONSIM_STOP_PROFILER("exponential_simulator::noContactsForwardDynamics");
+      lapStepPhase(StepStats::DYNAMICS);
       CONSIM_START_PROFILER("exponential_simulator::integrateState");
       vMean_ = v_ + .5 * sub_dt*dvMean_;
     } /*!< no active contacts */
@@ -123,20 +154,22 @@ void ExponentialSimulator::step(const Eigen::VectorXd &tau){
     q_ = qnext_;
     dv_ = dvMean_; 
     CONSIM_STOP_PROFILER("exponential_simulator::integrateState");
+    lapStepPhase(StepStats::INTEGRATION);
     
     CONSIM_START_PROFILER("exponential_simulator::computeContactForces");
     computeContactForces();
-    Eigen::internal::set_is_malloc_allowed(true);
+    setMallocAllowed(true);
     elapsedTime_ += sub_dt; 
     CONSIM_STOP_PROFILER("exponential_simulator::computeContactForces");
+    lapStepPhase(StepStats::CONTACTS);
+    endSubstepStats();
 
     CONSIM_STOP_PROFILER("exponential_simulator::substep");
   }  // sub_dt loop
-  CONSIM_STOP_PROFILER("exponential_simulator::step");
 } // ExponentialSimulator::step
 
 
-void ExponentialSimulator::computeExpLDS(bool update_A){
+bool ExponentialSimulator::computeExpLDS(bool update_A){
   /**
    * computes M, nle
    * fills J, dJv, p0, p, dp, Kp0, and x0 
@@ -145,16 +178,15 @@ void ExponentialSimulator::computeExpLDS(bool update_A){
   // Do we need to compute M before computing M inverse?
   B_copy = B;
   i_active_ = 0; 
-  for(auto &cp : contacts_){
-    if (!cp->active) continue;
-    Jc_.block(3*i_active_,0,3,model_->nv) = cp->world_J_;
-    dJv_.segment<3>(3*i_active_) = cp->dJv_; 
-    p0_.segment<3>(3*i_active_)  = cp->x_anchor; 
-    dp0_.segment<3>(3*i_active_)  = cp->v_anchor; 
-    p_.segment<3>(3*i_active_)   = cp->x; 
-    dp_.segment<3>(3*i_active_)  = cp->v;  
-    if (cp->slipping)
-        B_copy.diagonal().segment<3>(3*i_active_).setZero();
+  for(const int i : contacts_.getActiveIndices()){
+    Jc_.middleRows<3>(3*i_active_) = contacts_.J.middleRows<3>(3*i);
+    dJv_.segment<3>(3*i_active_) = contacts_[i]->dJv_; 
+    p0_.segment<3>(3*i_active_)  = contacts_.x_anchor.col(i); 
+    dp0_.segment<3>(3*i_active_)  = contacts_.v_anchor.col(i); 
+    p_.segment<3>(3*i_active_)   = contacts_.x.col(i); 
+    dp_.segment<3>(3*i_active_)  = contacts_.v.col(i);  
+    if (contacts_[i]->slipping)
+        B_copy.segment<3>(3*i_active_).setZero();
     i_active_ += 1;  
   }
   JcT_.noalias() = Jc_.transpose(); 
@@ -181,25 +213,53 @@ void ExponentialSimulator::computeExpLDS(bool update_A){
       MinvJcT_.col(i) = dv_;
     }
   }
+  else if(whichFD_==4){
+    // M = U D U^T has been factorized by forwardDynamics, so that
+    // Minv*Jc^T = U^-T D^-1/2 (D^-1/2 U^-1 Jc^T) and Jc*Minv*Jc^T = (D^-1/2 U^-1 Jc^T)^T (D^-1/2 U^-1 Jc^T)
+    CONSIM_START_PROFILER("exponential_simulator::choleskyContactSolve");
+    sqrtDinv_ = data_->Dinv.cwiseSqrt();
+    UinvJcT_ = JcT_;
+    pinocchio::cholesky::Uiv(*model_, *data_, UinvJcT_);
+    UinvJcT_ = sqrtDinv_.asDiagonal() * UinvJcT_;
+    MinvJcT_.noalias() = sqrtDinv_.asDiagonal() * UinvJcT_;
+    pinocchio::cholesky::Utiv(*model_, *data_, MinvJcT_);
+    CONSIM_STOP_PROFILER("exponential_simulator::choleskyContactSolve");
+  }
 
+  bool A_changed = update_A;
   if(update_A)
   {
-    Upsilon_.noalias() =  Jc_*MinvJcT_;
+    if(whichFD_==4)
+      Upsilon_.noalias() = UinvJcT_.transpose()*UinvJcT_;
+    else
+      Upsilon_.noalias() =  Jc_*MinvJcT_;
+    upsilon_patch_pending_ = false;
+  }
+  else if(upsilon_patch_pending_)
+  {
+    CONSIM_START_PROFILER("exponential_simulator::patchUpsilon");
+    patchUpsilon();
+    CONSIM_STOP_PROFILER("exponential_simulator::patchUpsilon");
+    A_changed = true;
+  }
+
+  if(A_changed)
+  {
     if(use_diagonal_matrix_exp_)
-      tempStepMat_.diagonal().noalias() =  Upsilon_.diagonal().cwiseProduct(K.diagonal());
+      tempStepMat_.diagonal().noalias() =  Upsilon_.diagonal().cwiseProduct(K);
     else
-      tempStepMat_.noalias() =  Upsilon_ * K;
+      tempStepMat_.noalias() =  Upsilon_ * K.asDiagonal();
     A.bottomLeftCorner(3*nactive_, 3*nactive_).noalias() = -tempStepMat_;  
 
-    DiagonalMatrixXd* B_to_use;
+    const VectorView* B_to_use;
     if(assumeSlippageContinues_)
       B_to_use = &B_copy; 
     else
       B_to_use = &B; 
     if(use_diagonal_matrix_exp_)
-      tempStepMat_.diagonal().noalias() =  Upsilon_.diagonal().cwiseProduct(B_to_use->diagonal());
+      tempStepMat_.diagonal().noalias() =  Upsilon_.diagonal().cwiseProduct(*B_to_use);
     else
-      tempStepMat_.noalias() = Upsilon_ * (*B_to_use); 
+      tempStepMat_.noalias() = Upsilon_ * B_to_use->asDiagonal(); 
     A.bottomRightCorner(3*nactive_, 3*nactive_).noalias() = -tempStepMat_; 
   }
   temp04_.noalias() = Jc_* dv_bar;  
@@ -207,6 +267,121 @@ void ExponentialSimulator::computeExpLDS(bool update_A){
   a_.tail(3*nactive_) = b_;
   x0_.head(3*nactive_) = p_-p0_; 
   x0_.tail(3*nactive_) = dp_;
+  return A_changed;
+}
+
+
+void ExponentialSimulator::saveUpsilonForPatch()
+{
+  /**
+   * called when the set of active contacts changes, before resizing the matrices: 
+   * stores Upsilon and, for every new active contact, its position in the old Upsilon 
+   **/
+  const std::vector<int> &active = contacts_.getActiveIndices();
+  UpsilonPrev_.topLeftCorner(Upsilon_.rows(), Upsilon_.cols()) = Upsilon_;
+  upsilonPrevPos_.assign(active.size(), -1);
+  // if the previous patch has not been applied yet, Upsilon does not contain valid blocks
+  if(!upsilon_patch_pending_){
+    for(unsigned int r=0; r<active.size(); ++r)
+      for(unsigned int k=0; k<upsilonIndices_.size(); ++k)
+        if(upsilonIndices_[k]==active[r]){
+          upsilonPrevPos_[r] = k;
+          break;
+        }
+  }
+  upsilonIndices_ = active;
+  upsilon_patch_pending_ = true;
+}
+
+
+void ExponentialSimulator::patchUpsilon()
+{
+  /**
+   * Upsilon blocks of the contacts that were already active are moved to their new position,
+   * while the rows and columns of the new contacts are computed as Jc_i * Minv * Jc^T
+   **/
+  for(int r=0; r<nactive_; ++r){
+    if(upsilonPrevPos_[r]<0) continue;
+    for(int c=0; c<nactive_; ++c){
+      if(upsilonPrevPos_[c]<0) continue;
+      Upsilon_.block<3,3>(3*r, 3*c) = UpsilonPrev_.block<3,3>(3*upsilonPrevPos_[r], 3*upsilonPrevPos_[c]);
+    }
+  }
+  for(int r=0; r<nactive_; ++r){
+    if(upsilonPrevPos_[r]>=0) continue;
+    Upsilon_.middleRows<3>(3*r).noalias() = Jc_.middleRows<3>(3*r) * MinvJcT_;
+    for(int c=0; c<nactive_; ++c)
+      if(c!=r)
+        Upsilon_.block<3,3>(3*c, 3*r) = Upsilon_.block<3,3>(3*r, 3*c).transpose();
+  }
+  upsilon_patch_pending_ = false;
+}
+
+
+void ExponentialSimulator::computeIntegralsXt(bool update_A)
+{
+  if(use_modal_exp_ && !allocation_free_){
+    if(update_A){
+      CONSIM_START_PROFILER("exponential_simulator::computeLDSModes");
+      const VectorView &B_used = assumeSlippageContinues_ ? B_copy : B;
+      setMallocAllowed(true); // the eigendecomposition allocates its workspace
+      modal_valid_ = !use_diagonal_matrix_exp_ && ldsModal_.compute(Upsilon_, K, B_used, sub_dt);
+      setMallocAllowed(false);
+      CONSIM_STOP_PROFILER("exponential_simulator::computeLDSModes");
+    }
+    if(modal_valid_){
+      ldsModal_.apply(a_, x0_, xT_, intxt_, int2xt_);
+      xT_computed_ = true;
+      return;
+    }
+  }
+
+  if(update_A_frequency_>1){
+    if(update_A){
+      CONSIM_START_PROFILER("exponential_simulator::computeLDSIntegralOperators");
+      ldsOperators_.compute(A, sub_dt);
+      CONSIM_STOP_PROFILER("exponential_simulator::computeLDSIntegralOperators");
+      stepStats_.expm_squarings += ldsOperators_.getSquarings();
+    }
+    ldsOperators_.apply(a_, x0_, xT_, intxt_, int2xt_);
+    xT_computed_ = true;
+    return;
+  }
+
+  if(use_expmv_ || (allocation_free_ && !(use_fixed_size_kernels_ && nactive_<=4))){
+    ldsExpmv_.compute(A, a_, x0_, sub_dt, xT_, intxt_, int2xt_);
+    stepStats_.matrix_multiplications += ldsExpmv_.getMatrixProducts();
+    xT_computed_ = true;
+    return;
+  }
+
+  xT_computed_ = use_fixed_size_kernels_;
+  if(use_fixed_size_kernels_){
+    switch (nactive_)
+    {
+    case 1:
+      ldsKernelOne_.compute(A, a_, x0_, sub_dt, xT_, intxt_, int2xt_);
+      stepStats_.expm_squarings += ldsKernelOne_.getSquarings();
+      return;
+    case 2:
+      ldsKernelTwo_.compute(A, a_, x0_, sub_dt, xT_, intxt_, int2xt_);
+      stepStats_.expm_squarings += ldsKernelTwo_.getSquarings();
+      return;
+    case 3:
+      ldsKernelThree_.compute(A, a_, x0_, sub_dt, xT_, intxt_, int2xt_);
+      stepStats_.expm_squarings += ldsKernelThree_.getSquarings();
+      return;
+    case 4:
+      ldsKernelFour_.compute(A, a_, x0_, sub_dt, xT_, intxt_, int2xt_);
+      stepStats_.expm_squarings += ldsKernelFour_.getSquarings();
+      return;
+    default:
+      xT_computed_ = false;
+      break;
+    }
+  }
+  utilDense_.ComputeIntegrals(A, a_, x0_, sub_dt, intxt_, int2xt_);
+  stepStats_.matrix_multiplications += utilDense_.getMatrixMultiplications();
 }
 
 
@@ -220,21 +395,28 @@ void ExponentialSimulator::computeContactForces()
    **/  
   
   CONSIM_START_PROFILER("exponential_simulator::kinematics");
-  pinocchio::forwardKinematics(*model_, *data_, q_, v_, fkDv_);
-  pinocchio::computeJointJacobians(*model_, *data_);
-  pinocchio::updateFramePlacements(*model_, *data_);
+  if(whichFD_==2){
+    // ABA does not use M and nle
+    pinocchio::forwardKinematics(*model_, *data_, q_, v_, fkDv_);
+    pinocchio::updateFramePlacements(*model_, *data_);
+  }
+  else{
+    // M and nle are computed with the kinematics and reused by the next forwardDynamics
+    computeKinematicsAndDynamics(q_, v_);
+  }
   CONSIM_STOP_PROFILER("exponential_simulator::kinematics");
 
   CONSIM_START_PROFILER("exponential_simulator::contactDetection");
   detectContacts(contacts_); /*!<inactive contacts get automatically filled with zero here */
+  // only the columns of the joints supporting the active contacts, nothing without contacts
+  computeContactJacobians(*model_, *data_, contacts_);
   CONSIM_STOP_PROFILER("exponential_simulator::contactDetection");
 
   if (nactive_>0){
-    bool size_changed = false;
-    if (f_.size()!=3*nactive_){
-      size_changed = true;
+    if (contacts_.getActiveIndices()!=upsilonIndices_){
       CONSIM_START_PROFILER("exponential_simulator::resizeVectorsAndMatrices");
       resizeVectorsAndMatrices();
+      stepStats_.resize_events += 1;
       CONSIM_STOP_PROFILER("exponential_simulator::resizeVectorsAndMatrices");
     }
     
@@ -254,11 +436,6 @@ void ExponentialSimulator::computeContactForces()
       // }
     }
     CONSIM_STOP_PROFILER("exponential_simulator::contactKinematics");
-
-    if(size_changed){
-      // force the update of A
-      update_A_counter_ = 1;
-    }
   }
 } // ExponentialSimulator::computeContactForces
 
@@ -270,7 +447,13 @@ void ExponentialSimulator::computePredictedXandF(){
    * computes \int{e^{dt*A}}
    * computes predictedXf = edtA x0 + int_edtA_ * b 
    **/  
-  Eigen::internal::set_is_malloc_allowed(true);
+  if(compute_predicted_forces_ && xT_computed_){
+    // the fixed-size kernels already computed x at the end of the step
+    predictedXf_ = xT_;
+    predictedForce_.noalias() = D*predictedXf_;
+    return;
+  }
+  setMallocAllowed(true);
   if(compute_predicted_forces_){
     util_eDtA.compute(sub_dt*A,expAdt_);   // TODO: there is memory allocation here 
     inteAdt_.fill(0);
@@ -304,7 +487,7 @@ void ExponentialSimulator::computePredictedXandF(){
     predictedForce_ = p0_;
     // predictedForce_ = kp0_; // this doesnt seem correct ?
   }
-  Eigen::internal::set_is_malloc_allowed(false);
+  setMallocAllowed(false);
 }
 
 
@@ -436,42 +619,85 @@ void ExponentialSimulator::checkFrictionCone(){
 
 
 
+void ExponentialSimulator::bindContactViews(int n)
+{
+  const int nv = model_->nv;
+  contactArena_.bind(f_, 3*n);
+  contactArena_.bind(p0_, 3*n);
+  contactArena_.bind(dp0_, 3*n);
+  contactArena_.bind(p_, 3*n);
+  contactArena_.bind(dp_, 3*n);
+  contactArena_.bind(a_, 6*n);
+  contactArena_.bind(b_, 3*n);
+  contactArena_.bind(x0_, 6*n);
+  contactArena_.bind(predictedXf_, 6*n);
+  contactArena_.bind(intxt_, 6*n);
+  contactArena_.bind(int2xt_, 6*n);
+  contactArena_.bind(xT_, 6*n);
+  contactArena_.bind(predictedForce_, 3*n);
+  contactArena_.bind(K, 3*n);
+  contactArena_.bind(B, 3*n);
+  contactArena_.bind(B_copy, 3*n);
+  contactArena_.bind(D, 3*n, 6*n);
+  contactArena_.bind(A, 6*n, 6*n);
+  contactArena_.bind(Jc_, 3*n, nv);
+  contactArena_.bind(JcT_, nv, 3*n);
+  contactArena_.bind(Upsilon_, 3*n, 3*n);
+  contactArena_.bind(MinvJcT_, nv, 3*n);
+  contactArena_.bind(UinvJcT_, nv, 3*n);
+  contactArena_.bind(dJv_, 3*n);
+  contactArena_.bind(f_avg, 3*n);
+  contactArena_.bind(f_avg2, 3*n);
+  contactArena_.bind(fpr_, 3*n);
+  contactArena_.bind(fpr2_, 3*n);
+  contactArena_.bind(tempStepMat_, 3*n, 3*n);
+  contactArena_.bind(temp03_, 3*n);
+  contactArena_.bind(temp04_, 3*n);
+}
+
+
+void ExponentialSimulator::reserveContactBuffers()
+{
+  /**
+   * memory for all the nc_ contact points, after this changes of the active set
+   * only rebind the views (expokit excluded, see setAllocationFree).
+   * The arena may have been reallocated, so the buffers are filled again at the next 
+   * computeContactForces, which sees a new set of active contacts.
+   **/
+  contactArena_.start(true);
+  bindContactViews(nc_);
+  contactArena_.reserve();
+  contactArena_.start();
+  bindContactViews(nactive_);
+  upsilonIndices_.clear();
+  if(UpsilonPrev_.rows() < 3*(int)nc_){
+    UpsilonPrev_.resize(3*nc_, 3*nc_);
+    upsilonPrevPos_.reserve(nc_);
+    upsilonIndices_.reserve(nc_);
+  }
+  ldsOperators_.reserve(6 * nc_);
+  ldsExpmv_.reserve(6 * nc_);
+  ldsModal_.reserve(3 * nc_);
+}
+
+
 void ExponentialSimulator::resizeVectorsAndMatrices()
 {
-  // Operations below need optimization, this is a first attempt
-  // resize matrices and fillout contact information
-  // TODO: change to use templated header dynamic_algebra.hpp
-  Eigen::internal::set_is_malloc_allowed(true);
+  // the views are bound to memory reserved at resetState, so only expokit allocates here
   if (nactive_>0){
-    f_.resize(3 * nactive_); f_.setZero();
-    p0_.resize(3 * nactive_); p0_.setZero();
-    dp0_.resize(3 * nactive_); dp0_.setZero();
-    p_.resize(3 * nactive_); p_.setZero();
-    dp_.resize(3 * nactive_); dp_.setZero();
-    a_.resize(6 * nactive_); a_.setZero();
-    b_.resize(3 * nactive_); b_.setZero();
-    x0_.resize(6 * nactive_); x0_.setZero();
-    predictedXf_.resize(6 * nactive_); predictedXf_.setZero();
-    intxt_.resize(6 * nactive_); intxt_.setZero();
-    int2xt_.resize(6 * nactive_); int2xt_.setZero();
-    K.resize(3 * nactive_); K.setZero();
-    B.resize(3 * nactive_); B.setZero();
-    D.resize(3 * nactive_, 6 * nactive_); D.setZero();
-    A.resize(6 * nactive_, 6 * nactive_); A.setZero();
-    A.block(0, 3*nactive_, 3*nactive_, 3*nactive_) = Eigen::MatrixXd::Identity(3*nactive_, 3*nactive_); 
-    Jc_.resize(3 * nactive_, model_->nv); Jc_.setZero();
-    JcT_.resize(model_->nv, 3 * nactive_); JcT_.setZero();
-    Upsilon_.resize(3 * nactive_, 3 * nactive_); Upsilon_.setZero();
-    MinvJcT_.resize(model_->nv, 3*nactive_); MinvJcT_.setZero();
-    dJv_.resize(3 * nactive_); dJv_.setZero();
-    utilDense_.resize(6 * nactive_);
-    f_avg.resize(3 * nactive_); f_avg.setZero();
-    f_avg2.resize(3 * nactive_); f_avg2.setZero();
-    fpr_.resize(3 * nactive_); fpr_.setZero();
-    fpr2_.resize(3 * nactive_); fpr2_.setZero();
-    tempStepMat_.resize(3 * nactive_, 3 * nactive_); tempStepMat_.setZero();
-    temp03_.resize(3*nactive_); temp03_.setZero();
-    temp04_.resize(3*nactive_); temp04_.setZero();
+    saveUpsilonForPatch();
+    contactArena_.start();
+    bindContactViews(nactive_);
+    contactArena_.setZero();
+    A.topRightCorner(3*nactive_, 3*nactive_).setIdentity(); 
+    if(!allocation_free_){
+      setMallocAllowed(true);
+      utilDense_.resize(6 * nactive_);
+      setMallocAllowed(false);
+    }
+    ldsOperators_.resize(6 * nactive_);
+    ldsExpmv_.resize(6 * nactive_);
+    ldsModal_.resize(3 * nactive_);
 
 
     // qp resizing 
@@ -507,8 +733,8 @@ void ExponentialSimulator::resizeVectorsAndMatrices()
     i_active_ = 0; 
     for(unsigned int i=0; i<nc_; i++){
       if (!contacts_[i]->active) continue;
-      K.diagonal().segment<3>(3*i_active_) = contacts_[i]->optr->contact_model_->stiffness_;
-      B.diagonal().segment<3>(3*i_active_) = contacts_[i]->optr->contact_model_->damping_;
+      K.segment<3>(3*i_active_) = contacts_[i]->optr->contact_model_->stiffness_;
+      B.segment<3>(3*i_active_) = contacts_[i]->optr->contact_model_->damping_;
 
       // fill up contact normals and tangents for constraints 
       // cone_constraints_.block<1,3>(4*i_active_, 3*i_active_) = (1/sqrt(2)) * contacts_[i]->optr->contact_model_->friction_coeff_*contacts_[i]->contactNormal_.transpose() - contacts_[i]->contactTangentA_.transpose();
@@ -520,8 +746,8 @@ void ExponentialSimulator::resizeVectorsAndMatrices()
       i_active_ += 1; 
     }
     // fillout D 
-    D.leftCols(3*nactive_) = -1*K;
-    D.rightCols(3*nactive_) = -1*B; 
+    D.leftCols(3*nactive_).diagonal() = -1*K;
+    D.rightCols(3*nactive_).diagonal() = -1*B; 
 
     // std::cout<<"resize vectors and matrices"<<std::endl;
     
@@ -529,9 +755,6 @@ void ExponentialSimulator::resizeVectorsAndMatrices()
   
   // std::cout<<"cone constraints \n"<<cone_constraints_<<std::endl; 
   // std::cout<<"contact velocity integrator \n"<<contact_position_integrator_<<std::endl; 
-
-
-  Eigen::internal::set_is_malloc_allowed(false);
 } // ExponentialSimulator::resizeVectorsAndMatrices
 
 
@@ -25,6 +25,9 @@
 #include <pinocchio/algorithm/cholesky.hpp>
 #include <pinocchio/algorithm/jacobian.hpp>
 #include <pinocchio/algorithm/aba-derivatives.hpp>
+#include <pinocchio/algorithm/kinematics-derivatives.hpp>
+#include <pinocchio/algorithm/frames-derivatives.hpp>
+#include <pinocchio/spatial/skew.hpp>
 
 #include "consim/object.hpp"
 #include "consim/contact.hpp"
@@ -45,11 +48,16 @@ namespace consim
 
 ImplicitEulerSimulator::ImplicitEulerSimulator(const pinocchio::Model &model, pinocchio::Data &data, float dt, int n_integration_steps):
 EulerSimulator(model, data, dt, n_integration_steps, 3, EXPLICIT),
-use_finite_differences_dynamics_(true),
-use_finite_differences_nle_(true),
+use_finite_differences_dynamics_(false),
+use_finite_differences_nle_(false),
 use_current_state_as_initial_guess_(true),
+use_structured_newton_solve_(true),
+reuse_jacobian_(false),
+jacobian_valid_(false),
 convergence_threshold_(1e-8),
-regularization_(1e-10)
+jacobian_reuse_contraction_(0.5),
+regularization_(1e-10),
+jacobian_regularization_(1e-10)
 {
   const int nv = model.nv, nq=model.nq;
   int nx = nq+nv;
@@ -73,23 +81,59 @@ regularization_(1e-10)
   f_.resize(ndx);f_.setZero();
   g_.resize(ndx);g_.setZero();
   dz_.resize(ndx);dz_.setZero();
+  x_eps_.resize(nx); x_eps_.setZero();
+  dx_eps_.resize(ndx); dx_eps_.setZero();
+  f_eps_.resize(ndx); f_eps_.setZero();
+  delta_z_eps_.resize(ndx); delta_z_eps_.setZero();
+  zEps_.resize(nx); zEps_.setZero();
+  gEps_.resize(ndx); gEps_.setZero();
 
   tau_f_.resize(nv); tau_f_.setZero();
   tau_plus_JT_f_.resize(nv); tau_plus_JT_f_.setZero();
 
-  const int nactive=0;
-  lambda_.resize(3 * nactive); lambda_.setZero();
-  K_.resize(3 * nactive); K_.setZero();
-  B_.resize(3 * nactive); B_.setZero();
-  Jc_.resize(3 * nactive, nv); Jc_.setZero();
-  MinvJcT_.resize(nv, 3*nactive); MinvJcT_.setZero();
+  fext_.resize(model.njoints, pinocchio::Force::Zero());
+  dv_dq_.resize(6, nv); dv_dq_.setZero();
+  dv_dv_.resize(6, nv); dv_dv_.setZero();
+  dfraw_dq_.resize(3, nv); dfraw_dq_.setZero();
+  dfraw_dv_.resize(3, nv); dfraw_dv_.setZero();
+
+  allocateContactBuffers();
   G_LU_ = PartialPivLU<MatrixXd>(ndx);
+
+  PinvQ_.resize(nv, nv); PinvQ_.setZero();
+  S_.resize(nv, nv); S_.setZero();
+  S_LU_ = PartialPivLU<MatrixXd>(nv);
+  P_LU_.resize(model.njoints);
+  Pinv_g1_.resize(nv); Pinv_g1_.setZero();
+  rhs_v_.resize(nv); rhs_v_.setZero();
+  set_use_structured_newton_solve(true);
+}
+
+void ImplicitEulerSimulator::allocateContactBuffers()
+{
+  const int nv = model_->nv;
+  contactsCopy_ = contacts_;
+  lambda_.resize(3 * nc_); lambda_.setZero();
+  Jc_.resize(3 * nc_, nv); Jc_.setZero();
+  MinvJcT_.resize(nv, 3*nc_); MinvJcT_.setZero();
+  dF_dq_.resize(3 * nc_, nv); dF_dq_.setZero();
+  dF_dv_.resize(3 * nc_, nv); dF_dv_.setZero();
+  jacobianIndices_.reserve(nc_);
 }
 
-void ImplicitEulerSimulator::set_use_finite_differences_dynamics(bool value) { use_finite_differences_dynamics_ = value; }
+void ImplicitEulerSimulator::reserveContactBuffers()
+{
+  if (contactsCopy_.size() != contacts_.size())
+    allocateContactBuffers();
+  jacobianIndices_.clear();
+  // the factorization was computed before the reset, at an unrelated state
+  jacobian_valid_ = false;
+}
+
+void ImplicitEulerSimulator::set_use_finite_differences_dynamics(bool value) { use_finite_differences_dynamics_ = value; jacobian_valid_ = false; }
 bool ImplicitEulerSimulator::get_use_finite_differences_dynamics() const{ return use_finite_differences_dynamics_; }
 
-void ImplicitEulerSimulator::set_use_finite_differences_nle(bool value) { use_finite_differences_nle_ = value; }
+void ImplicitEulerSimulator::set_use_finite_differences_nle(bool value) { use_finite_differences_nle_ = value; jacobian_valid_ = false; }
 bool ImplicitEulerSimulator::get_use_finite_differences_nle() const{ return use_finite_differences_nle_; }
 
 void ImplicitEulerSimulator::set_use_current_state_as_initial_guess(bool value){ use_current_state_as_initial_guess_ = value; }
@@ -98,19 +142,27 @@ bool ImplicitEulerSimulator::get_use_current_state_as_initial_guess() const { re
 void ImplicitEulerSimulator::set_convergence_threshold(double value){ convergence_threshold_ = value; }
 double ImplicitEulerSimulator::get_convergence_threshold() const{ return convergence_threshold_; }
 
+void ImplicitEulerSimulator::set_use_structured_newton_solve(bool value)
+{ 
+  use_structured_newton_solve_ = value; 
+  for(int j=1; j<model_->njoints; ++j)
+    if(model_->joints[j].nv()>6)
+      use_structured_newton_solve_ = false;
+  jacobian_valid_ = false; 
+}
+bool ImplicitEulerSimulator::get_use_structured_newton_solve() const { return use_structured_newton_solve_; }
+
+void ImplicitEulerSimulator::set_reuse_jacobian(bool value){ reuse_jacobian_ = value; jacobian_valid_ = false; }
+bool ImplicitEulerSimulator::get_reuse_jacobian() const { return reuse_jacobian_; }
+
 double ImplicitEulerSimulator::get_avg_iteration_number() const { return avg_iteration_number_; }
+double ImplicitEulerSimulator::get_avg_jacobian_update_number() const { return avg_jacobian_update_number_; }
 
 int ImplicitEulerSimulator::computeDynamics(const Eigen::VectorXd &tau, const Eigen::VectorXd &x, Eigen::VectorXd &f)
 {
-  // create a copy of the current contacts
+  // restore the state of the current contacts in the preallocated snapshot
   CONSIM_START_PROFILER("imp_euler_simulator::copyContacts");
-  for(auto &cp: contactsCopy_){
-    delete cp;
-  }
-  contactsCopy_.clear();
-  for(auto &cp: contacts_){
-    contactsCopy_.push_back(new ContactPoint(*cp));
-  }
+  contactsCopy_.copyStateFrom(contacts_);
   CONSIM_STOP_PROFILER("imp_euler_simulator::copyContacts");
 
   const int nq = model_->nq, nv = model_->nv;
@@ -135,58 +187,84 @@ void ImplicitEulerSimulator::computeDynamicsJacobian(const Eigen::VectorXd &tau,
   if(use_finite_differences_dynamics_)
   {  
     const double epsilon = 1e-8;
-    VectorXd x_eps(nq+nv), dx_eps(2*nv), f_eps(2*nv);
     for(int i=0; i<2*nv; ++i)
     {
       // cout<<"Fx "<<i<<endl;
-      dx_eps.setZero();
-      dx_eps[i] = epsilon;
-      integrateState(*model_, x, dx_eps, 1.0, x_eps);
-      computeDynamics(tau, x_eps, f_eps);
+      dx_eps_.setZero();
+      dx_eps_[i] = epsilon;
+      integrateState(*model_, x, dx_eps_, 1.0, x_eps_);
+      computeDynamics(tau, x_eps_, f_eps_);
       // cout<<"xEps: "<<x_eps.transpose()<<endl;
       // cout<<"fEps: "<<f_eps.transpose()<<endl;
       // cout<<"Fx[i]: "<<((f_eps.tail(nv) - f.tail(nv))/epsilon).transpose()<<endl;
-      Fx.block(nv, i, nv, 1) = (f_eps.tail(nv) - f.tail(nv))/epsilon;
+      Fx.block(nv, i, nv, 1) = (f_eps_.tail(nv) - f.tail(nv))/epsilon;
     }
   }
   else
   {  
-    // compute contact Jacobian and contact forces
-    if (nactive_>0){
-      CONSIM_START_PROFILER("imp_euler_simulator::update_J_K_B_f");
-      lambda_.resize(3 * nactive_); lambda_.setZero();
-      K_.resize(3 * nactive_); K_.setZero();
-      B_.resize(3 * nactive_); B_.setZero();
-      Jc_.resize(3 * nactive_, model_->nv); Jc_.setZero();
-      MinvJcT_.resize(model_->nv, 3*nactive_); MinvJcT_.setZero();
-  
+    /**
+     * Analytic Jacobian of ddq = ABA(q, v, tau + Jc^T f(q,v)) where the contact forces are
+     *    f = P(K*(x_anchor - x) - B*v)
+     * with P the friction cone projection (identity when sticking, zero on release).
+     * computeABADerivatives with the contact forces as external forces accounts for the 
+     * dependency of Jc on q (with forces fixed in the joint frames), the rest is added as
+     *    Minv * Jc^T * (df/dq + [f]x * Jw)
+     * where the last term corrects for the forces being fixed in the world frame.
+     */
+    // evaluate the contacts at x: after a rejected line search step the snapshot holds another state
+    contactsCopy_.copyStateFrom(contacts_);
+    const int nactive = computeContactForces_imp(*model_, *data_, x.head(nq), x.tail(nv), tau_f_, contactsCopy_, objects_);
+    const int nk = 3*nactive;
+
+    for (auto &fext : fext_)
+      fext.setZero();
+    if (nactive>0){
+      CONSIM_START_PROFILER("imp_euler_simulator::contactForceDerivatives");
+      pinocchio::computeForwardKinematicsDerivatives(*model_, *data_, x.head(nq), x.tail(nv), fkDv_);
       int i_active_ = 0; 
-      for(unsigned int i=0; i<nc_; i++){
+      for(const int i : contactsCopy_.getActiveIndices()){
         ContactPoint *cp = contactsCopy_[i];
-        if (!cp->active) continue;
-        Jc_.block(3*i_active_,0,3,model_->nv) = cp->world_J_;
-        K_.diagonal().segment<3>(3*i_active_) = cp->optr->contact_model_->stiffness_;
-        B_.diagonal().segment<3>(3*i_active_) = cp->optr->contact_model_->damping_;
-        lambda_.segment<3>(3*i_active_) = cp->f;
+        const ContactModel *cm = cp->optr->contact_model_;
+        const int k = 3*i_active_;
+        Jc_.middleRows<3>(k) = contactsCopy_.J.middleRows<3>(3*i);
+        lambda_.segment<3>(k) = contactsCopy_.f.col(i);
+
+        // contact force applied at the contact point, expressed in the frame of the parent joint
+        const pinocchio::JointIndex joint = model_->frames[cp->frame_id].parent;
+        fext_[joint] += data_->oMi[joint].actInv(pinocchio::Force(contactsCopy_.f.col(i), 
+                                                   contactsCopy_.x.col(i).cross(contactsCopy_.f.col(i))));
+
+        // derivatives of the visco-elastic force K*(x_anchor - x) - B*v
+        dv_dq_.setZero(); dv_dv_.setZero();
+        pinocchio::getFrameVelocityDerivatives(*model_, *data_, cp->frame_id, pinocchio::LOCAL_WORLD_ALIGNED, dv_dq_, dv_dv_);
+        dfraw_dq_.noalias() = -(cm->stiffness_.asDiagonal() * Jc_.middleRows<3>(k));
+        dfraw_dq_.noalias() -= cm->damping_.asDiagonal() * dv_dq_.topRows<3>();
+        dfraw_dv_.noalias() = -(cm->damping_.asDiagonal() * Jc_.middleRows<3>(k));
+
+        // chain rule through the friction cone projection
+        cm->computeForceProjectionJacobian(*cp, P_);
+        dF_dq_.middleRows<3>(k).noalias() = P_ * dfraw_dq_;
+        dF_dv_.middleRows<3>(k).noalias() = P_ * dfraw_dv_;
+        dF_dq_.middleRows<3>(k).noalias() += pinocchio::skew(contactsCopy_.f.col(i)) * cp->full_J_.bottomRows<3>();
         i_active_ += 1; 
       }
-      CONSIM_STOP_PROFILER("imp_euler_simulator::update_J_K_B_f");
+      CONSIM_STOP_PROFILER("imp_euler_simulator::contactForceDerivatives");
     } 
 
     CONSIM_START_PROFILER("imp_euler_simulator::computeABADerivatives");
-    pinocchio::computeABADerivatives(*model_, *data_, x.head(nq), x.tail(nv), tau);
+    pinocchio::computeABADerivatives(*model_, *data_, x.head(nq), x.tail(nv), tau, fext_);
     Fx.bottomLeftCorner(nv, nv) = data_->ddq_dq;
     Fx.bottomRightCorner(nv, nv) = data_->ddq_dv;
     CONSIM_STOP_PROFILER("imp_euler_simulator::computeABADerivatives");
 
-    if (nactive_>0){
-      CONSIM_START_PROFILER("imp_euler_simulator::Minv_JT_K_J");
+    if (nactive>0){
+      CONSIM_START_PROFILER("imp_euler_simulator::Minv_JT_dfdx");
       data_->Minv.triangularView<Eigen::StrictlyLower>()
       = data_->Minv.transpose().triangularView<Eigen::StrictlyLower>(); // need to fill the Lower part of the matrix
-      MinvJcT_.noalias() = data_->Minv * Jc_.transpose(); 
-      Fx.bottomLeftCorner(nv, nv)  -= MinvJcT_ * K_ * Jc_;
-      Fx.bottomRightCorner(nv, nv) -= MinvJcT_ * B_ * Jc_;
-      CONSIM_STOP_PROFILER("imp_euler_simulator::Minv_JT_K_J");
+      MinvJcT_.leftCols(nk).noalias() = data_->Minv * Jc_.topRows(nk).transpose(); 
+      Fx.bottomLeftCorner(nv, nv).noalias()  += MinvJcT_.leftCols(nk) * dF_dq_.topRows(nk);
+      Fx.bottomRightCorner(nv, nv).noalias() += MinvJcT_.leftCols(nk) * dF_dv_.topRows(nk);
+      CONSIM_STOP_PROFILER("imp_euler_simulator::Minv_JT_dfdx");
     }
     // cout<<"Fx:\n"<<Fx<<endl;
   }
@@ -207,18 +285,194 @@ void ImplicitEulerSimulator::computeNonlinearEquations(const Eigen::VectorXd &ta
   CONSIM_STOP_PROFILER("imp_euler_simulator::computeNonlinearEquations");
 }
 
+void ImplicitEulerSimulator::factorizeStructuredNewtonSystem()
+{
+  /**
+   * With Fx = [0, I; A, B] the (regularized) Newton matrix has the block form
+   *    G = [P, Q; -hA, I-hB] + rI,   P = Ddiff_Dx1,  Q = h*Ddiff_Dx0*Dint
+   * where P and Q are block diagonal (one block per joint). Eliminating dq gives
+   *    S = (1+r)I - hB + hA*(P+rI)^-1*Q
+   * so only the nv x nv matrix S needs a dense LU. S is not symmetric, so the sparse 
+   * Cholesky factorization of the mass matrix cannot be used here.
+   */
+  CONSIM_START_PROFILER("imp_euler_simulator::factorizeStructuredNewtonSystem");
+  const int nv = model_->nv;
+  const double h = sub_dt;
+  S_.noalias() = -h * Fx_.bottomRightCorner(nv, nv);
+  jacobian_regularization_ = regularization_;
+  S_.diagonal().array() += 1.0 + jacobian_regularization_;
+  for(int j=1; j<model_->njoints; ++j)
+  {
+    const int iv = model_->joints[j].idx_v(), nvj = model_->joints[j].nv();
+    auto PinvQ_j = PinvQ_.block(iv, iv, nvj, nvj);
+    PinvQ_j.noalias() = h * Ddifference_Dx0_.block(iv, iv, nvj, nvj) * Dintegrate_Ddx_.block(iv, iv, nvj, nvj);
+    if(nvj==1){
+      PinvQ_j /= Ddifference_Dx1_(iv, iv) + jacobian_regularization_;
+    }
+    else{
+      JointMatrix Pj = Ddifference_Dx1_.block(iv, iv, nvj, nvj);
+      Pj.diagonal().array() += jacobian_regularization_;
+      P_LU_[j].compute(Pj);
+      Pj = P_LU_[j].solve(PinvQ_j);
+      PinvQ_j = Pj;
+    }
+    S_.middleCols(iv, nvj).noalias() += h * Fx_.block(nv, iv, nv, nvj) * PinvQ_j;
+  }
+  S_LU_.compute(S_);
+  CONSIM_STOP_PROFILER("imp_euler_simulator::factorizeStructuredNewtonSystem");
+}
+
+void ImplicitEulerSimulator::solveStructuredNewtonSystem(const Eigen::VectorXd &g, Eigen::VectorXd &dz)
+{
+  // G*dz = g with g = [g1; g2]:  S*dv = g2 + hA*P^-1*g1,  dq = P^-1*g1 - P^-1*Q*dv
+  const int nv = model_->nv;
+  for(int j=1; j<model_->njoints; ++j)
+  {
+    const int iv = model_->joints[j].idx_v(), nvj = model_->joints[j].nv();
+    if(nvj==1)
+      Pinv_g1_(iv) = g(iv) / (Ddifference_Dx1_(iv, iv) + jacobian_regularization_);
+    else
+      Pinv_g1_.segment(iv, nvj) = P_LU_[j].solve(g.segment(iv, nvj));
+  }
+  rhs_v_ = g.tail(nv);
+  rhs_v_.noalias() += sub_dt * Fx_.bottomLeftCorner(nv, nv) * Pinv_g1_;
+  dz.tail(nv) = S_LU_.solve(rhs_v_);
+  dz.head(nv) = Pinv_g1_;
+  for(int j=1; j<model_->njoints; ++j)
+  {
+    const int iv = model_->joints[j].idx_v(), nvj = model_->joints[j].nv();
+    dz.segment(iv, nvj).noalias() -= PinvQ_.block(iv, iv, nvj, nvj) * dz.segment(nv+iv, nvj);
+  }
+}
+
+void ImplicitEulerSimulator::computeNewtonStep(bool update_jacobian)
+{
+  if(update_jacobian)
+  {
+    if(use_finite_differences_nle_)
+    {
+      const int ndx = 2*model_->nv;
+      const double eps = 1e-8;
+      for(int k=0; k<ndx; ++k)
+      {
+        // perturb z in direction k
+        // cout<<"k="<<k<<endl;
+        delta_z_eps_.setZero();
+        delta_z_eps_(k) = eps;
+        integrateState(*model_, z_, delta_z_eps_, 1.0, zEps_);
+        // recompute nonlinear equations with perturbed z
+        computeNonlinearEquations(tau_, x_, zEps_, gEps_);
+        G_.col(k) = (gEps_ - g_)/eps;
+      }
+    }
+    else
+    {
+      CONSIM_START_PROFILER("imp_euler_simulator::computeNewtonSystem");
+      // Compute gradient G = I - h*Fx
+      computeDynamicsJacobian(tau_, z_, f_, Fx_);
+      // g = diff(int(x, h*f(z)), z)
+      // G = Dg/Dz = Ddiff_Dx1 + h * Ddiff_Dx0 * Dint * Fx
+      DintegrateState(    *model_, x_, f_, sub_dt,   Dintegrate_Ddx_);
+      // cout<<"Dintegrate_Ddx_ = \n"<<Dintegrate_Ddx_<<endl;
+      DdifferenceState_x0(*model_, xIntegrated_, z_, Ddifference_Dx0_);
+      // cout<<"Ddifference_Dx0_ = \n"<<Ddifference_Dx0_<<endl;
+      DdifferenceState_x1(*model_, xIntegrated_, z_, Ddifference_Dx1_);
+      // cout<<"Ddifference_Dx1_ = \n"<<Ddifference_Dx1_<<endl;
+      if(!use_structured_newton_solve_)
+      {
+        CONSIM_START_PROFILER("imp_euler_simulator::computeNewtonSystem-matmatmult");
+        Dintegrate_Ddx_Fx_.noalias() = Dintegrate_Ddx_ * Fx_;
+        Ddifference_Dx0_Dintegrate_Ddx_Fx_.noalias() = Ddifference_Dx0_ * Dintegrate_Ddx_Fx_;
+        CONSIM_STOP_PROFILER("imp_euler_simulator::computeNewtonSystem-matmatmult");
+        G_.noalias() = sub_dt * Ddifference_Dx0_Dintegrate_Ddx_Fx_;
+        G_ += Ddifference_Dx1_;
+        // G_.setIdentity();
+        // G_ -= sub_dt * Fx_;
+      }
+      CONSIM_STOP_PROFILER("imp_euler_simulator::computeNewtonSystem");
+    }
+  }
+  // cout<<"G\n"<<G_<<endl;
+
+  CONSIM_START_PROFILER("imp_euler_simulator::solveNewtonSystem");
+  // Update with Newton step: z += solve(G, -g)
+  g_ *= -1;
+  // G is built explicitly only with finite differences, otherwise its block structure is exploited
+  const bool structured_solve = use_structured_newton_solve_ && !use_finite_differences_nle_;
+  if(update_jacobian){
+    if(structured_solve){
+      factorizeStructuredNewtonSystem();
+    }
+    else{
+      jacobian_regularization_ = regularization_;
+      G_.diagonal().array() += jacobian_regularization_;
+      G_LU_.compute(G_);
+    }
+    // active contacts of the last evaluation of the dynamics, i.e. those used to build G
+    jacobianIndices_ = contactsCopy_.getActiveIndices();
+    jacobian_valid_ = true;
+  }
+  if(structured_solve)
+    solveStructuredNewtonSystem(g_, dz_);
+  else
+    dz_ = G_LU_.solve(g_);
+  // dz_ = G_.colPivHouseholderQr().solve(g_); // slower than LU
+  // dz_ = G_.partialPivLu().solve(g_);
+  // dz_ = G_.ldlt().solve(g_); // cannot use LDLT decomposition because G is not PD in general
+  // cout<<"dz = "<<dz_.transpose()<<endl;
+  CONSIM_STOP_PROFILER("imp_euler_simulator::solveNewtonSystem");
+}
+
+void ImplicitEulerSimulator::evaluateNewtonStep(const Eigen::VectorXd &tau, Eigen::MatrixXd &Fx, Eigen::VectorXd &dz)
+{
+  if(!resetflag_){
+    throw std::runtime_error("resetState() must be called first !");
+  }
+  if (contactsCopy_.size() != contacts_.size())
+    allocateContactBuffers();
+
+  // tau_ holds J^T*f of the current contact forces, used by the next step
+  const Eigen::VectorXd tau_contacts = tau_;
+  const int nactive = nactive_;
+  x_.head(model_->nq) = q_;
+  x_.tail(model_->nv) = v_;
+  z_ = x_;
+  tau_ = tau;
+  if (joint_friction_flag_){
+    tau_ -= joint_friction_.cwiseProduct(v_);
+  }
+  computeNonlinearEquations(tau_, x_, z_, g_);
+  computeNewtonStep(true);
+  Fx = Fx_;
+  dz = dz_;
+
+  // the factorization has been computed at another guess than the one of the next step
+  jacobian_valid_ = false;
+  nactive_ = nactive;
+  tau_ = tau_contacts;
+}
+
 void ImplicitEulerSimulator::step(const Eigen::VectorXd &tau) 
 {
   if(!resetflag_){
     throw std::runtime_error("resetState() must be called first !");
   }
-  CONSIM_START_PROFILER("imp_euler_simulator::step");
+  CONSIM_PROFILER_SCOPE("imp_euler_simulator::step");
   assert(tau.size() == model_->nv);
 
+  startStepStats();
+  // allocate the contact buffers only when contact points have been added
+  if (contactsCopy_.size() != contacts_.size()){
+    allocateContactBuffers();
+    jacobian_valid_ = false;
+    stepStats_.resize_events += 1;
+  }
+
   avg_iteration_number_ = 0.0;
+  avg_jacobian_update_number_ = 0.0;
   for (int i = 0; i < n_integration_steps_; i++)
   {
-    // Eigen::internal::set_is_malloc_allowed(false);
+    setMallocAllowed(false);
     CONSIM_START_PROFILER("imp_euler_simulator::substep");
     // add input control to contact forces J^T*f that are already in tau_
     tau_ += tau;
@@ -270,61 +524,16 @@ void ImplicitEulerSimulator::step(const Eigen::VectorXd &tau)
         break;
       }
       
-      if(use_finite_differences_nle_)
-      {
-        const int ndx = 2*model_->nv;
-        VectorXd delta_z_eps(ndx), zEps(z_.size()), gEps(ndx);
-        const double eps = 1e-8;
-        for(int k=0; k<ndx; ++k)
-        {
-          // perturb z in direction k
-          // cout<<"k="<<k<<endl;
-          delta_z_eps.setZero();
-          delta_z_eps(k) = eps;
-          integrateState(*model_, z_, delta_z_eps, 1.0, zEps);
-          // recompute nonlinear equations with perturbed z
-          computeNonlinearEquations(tau_, x_, zEps, gEps);
-          G_.col(k) = (gEps - g_)/eps;
-        }
-      }
-      else
-      {
-        CONSIM_START_PROFILER("imp_euler_simulator::computeNewtonSystem");
-        // Compute gradient G = I - h*Fx
-        computeDynamicsJacobian(tau_, z_, f_, Fx_);
-        // g = diff(int(x, h*f(z)), z)
-        // G = Dg/Dz = Ddiff_Dx1 + h * Ddiff_Dx0 * Dint * Fx
-        DintegrateState(    *model_, x_, f_, sub_dt,   Dintegrate_Ddx_);
-        // cout<<"Dintegrate_Ddx_ = \n"<<Dintegrate_Ddx_<<endl;
-        DdifferenceState_x0(*model_, xIntegrated_, z_, Ddifference_Dx0_);
-        // cout<<"Ddifference_Dx0_ = \n"<<Ddifference_Dx0_<<endl;
-        DdifferenceState_x1(*model_, xIntegrated_, z_, Ddifference_Dx1_);
-        // cout<<"Ddifference_Dx1_ = \n"<<Ddifference_Dx1_<<endl;
-        CONSIM_START_PROFILER("imp_euler_simulator::computeNewtonSystem-matmatmult");
-        Dintegrate_Ddx_Fx_.noalias() = Dintegrate_Ddx_ * Fx_;
-        Ddifference_Dx0_Dintegrate_Ddx_Fx_.noalias() = Ddifference_Dx0_ * Dintegrate_Ddx_Fx_;
-        CONSIM_STOP_PROFILER("imp_euler_simulator::computeNewtonSystem-matmatmult");
-        G_.noalias() = sub_dt * Ddifference_Dx0_Dintegrate_Ddx_Fx_;
-        G_ += Ddifference_Dx1_;
-        // G_.setIdentity();
-        // G_ -= sub_dt * Fx_;
-        CONSIM_STOP_PROFILER("imp_euler_simulator::computeNewtonSystem");
+      // when the Jacobian is reused, G and its factorization are kept from a previous iteration
+      const bool update_jacobian = !reuse_jacobian_ || !jacobian_valid_;
+      computeNewtonStep(update_jacobian);
+      if(update_jacobian){
+        avg_jacobian_update_number_ += 1;
+        stepStats_.jacobian_updates += 1;
       }
-      // cout<<"G\n"<<G_<<endl;
-
-      CONSIM_START_PROFILER("imp_euler_simulator::solveNewtonSystem");
-      // Update with Newton step: z += solve(G, -g)
-      g_ *= -1;
-      G_ += regularization_ * MatrixXd::Identity(2*model_->nv, 2*model_->nv);
-      G_LU_.compute(G_);
-      dz_ = G_LU_.solve(g_);
-      // dz_ = G_.colPivHouseholderQr().solve(g_); // slower than LU
-      // dz_ = G_.partialPivLu().solve(g_);
-      // dz_ = G_.ldlt().solve(g_); // cannot use LDLT decomposition because G is not PD in general
-      // cout<<"dz = "<<dz_.transpose()<<endl;
-      CONSIM_STOP_PROFILER("imp_euler_simulator::solveNewtonSystem");
 
       CONSIM_START_PROFILER("imp_euler_simulator::lineSearch");
+      const double old_residual = residual;
       double alpha = 1.0, new_residual;
       bool line_search_converged = false;
       for(int k=0; k<20 && !line_search_converged; ++k)
@@ -337,6 +546,7 @@ void ImplicitEulerSimulator::step(const Eigen::VectorXd &tau)
         new_residual = g_.norm();
         if(new_residual >= residual){
           alpha *= 0.5;
+          stepStats_.line_search_backtracks += 1;
         }
         else{
           line_search_converged = true;
@@ -352,6 +562,17 @@ void ImplicitEulerSimulator::step(const Eigen::VectorXd &tau)
       } // end of line search
       CONSIM_STOP_PROFILER("imp_euler_simulator::lineSearch");
 
+      if(!update_jacobian && (!line_search_converged || residual > jacobian_reuse_contraction_*old_residual))
+      {
+        // convergence stalled with the reused Jacobian: recompute it at the next iteration
+        jacobian_valid_ = false;
+        if(!line_search_converged){
+          // restore the residual (and the contact state) of the current guess
+          computeNonlinearEquations(tau_, x_, z_, g_);
+          continue;
+        }
+      }
+
       if(!line_search_converged)
       {
         regularization_ *= 10;
@@ -368,22 +589,29 @@ void ImplicitEulerSimulator::step(const Eigen::VectorXd &tau)
       // cout<<"z="<<z_.transpose()<<endl;
     }
     avg_iteration_number_ += j;
+    stepStats_.newton_iterations += j;
 
     // if(!converged && residual>=convergence_threshold_)
       // cout<<"Substep "<<i<<" iter "<<j<<" Implicit Euler did not converge!!!! |g|="<<residual<<endl;
     
     q_ = z_.head(model_->nq);
     v_ = z_.tail(model_->nv);
+    lapStepPhase(StepStats::DYNAMICS);
     
     tau_.setZero();
     // \brief adds contact forces to tau_
     computeContactForces(); 
-    // Eigen::internal::set_is_malloc_allowed(true);
+    // a reused Jacobian is stale as soon as the set of active contacts differs from the one it was built with
+    if(contacts_.getActiveIndices()!=jacobianIndices_)
+      jacobian_valid_ = false;
+    lapStepPhase(StepStats::CONTACTS);
+    endSubstepStats();
+    setMallocAllowed(true);
     CONSIM_STOP_PROFILER("imp_euler_simulator::substep");
     elapsedTime_ += sub_dt; 
   }
   avg_iteration_number_ /= n_integration_steps_;
-  CONSIM_STOP_PROFILER("imp_euler_simulator::step");
+  avg_jacobian_update_number_ /= n_integration_steps_;
 }
 
 }  // namespace consim 
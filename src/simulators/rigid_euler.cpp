@@ -44,6 +44,8 @@ namespace consim
 RigidEulerSimulator::RigidEulerSimulator(const pinocchio::Model &model, pinocchio::Data &data, float dt, int n_integration_steps):
 EulerSimulator(model, data, dt, n_integration_steps, 3, EXPLICIT),
 integration_scheme_(1),
+Jc_(NULL, 0, 0),
+dJv_(NULL, 0),
 regularization_(1e-12),
 kp_(0.0),
 kd_(0.0)
@@ -51,14 +53,11 @@ kd_(0.0)
   const int nv = model.nv, nq=model.nq;
   int nx = nq+nv;
   int ndx = 2*nv;
-  int nf=0;
 
   tau_f_.resize(nv); tau_f_.setZero();
   x_.resize(nx); x_.setZero();
   x_next_.resize(nx); x_next_.setZero();
   f_.resize(ndx); f_.setZero();
-  Jc_.resize(3 * nf, nv); Jc_.setZero();
-  dJv_.resize(3 * nf); dJv_.setZero();
 
   for(int i = 0; i<4; i++){
     xi_.push_back(Eigen::VectorXd::Zero(nx));
@@ -83,7 +82,18 @@ void RigidEulerSimulator::set_contact_stabilization_gains(double kp, double kd)
   kd_ = kd;
 }
 
-void RigidEulerSimulator::computeContactForces(const Eigen::VectorXd &x, std::vector<ContactPoint *> &contacts)
+void RigidEulerSimulator::reserveContactBuffers()
+{
+  contactArena_.start(true);
+  contactArena_.bind(Jc_, 3*nc_, model_->nv);
+  contactArena_.bind(dJv_, 3*nc_);
+  contactArena_.reserve();
+  contactArena_.start();
+  contactArena_.bind(Jc_, 0, model_->nv);
+  contactArena_.bind(dJv_, 0);
+}
+
+void RigidEulerSimulator::computeContactForces(const Eigen::VectorXd &x, ContactSet &contacts)
 {
   /**
    * computes the kinematics at the end of the integration step, 
@@ -95,19 +105,22 @@ void RigidEulerSimulator::computeContactForces(const Eigen::VectorXd &x, std::ve
 
   CONSIM_START_PROFILER("rigid_euler_simulator::kinematics");
   pinocchio::forwardKinematics(*model_, *data_, x.head(nq), x.tail(nv), fkDv_);
-  pinocchio::computeJointJacobians(*model_, *data_);
   pinocchio::updateFramePlacements(*model_, *data_);
   CONSIM_STOP_PROFILER("rigid_euler_simulator::kinematics");
 
   CONSIM_START_PROFILER("rigid_euler_simulator::contactDetection");
   detectContacts(contacts); /*!<inactive contacts get automatically filled with zero here */
+  computeContactJacobians(*model_, *data_, contacts);
   CONSIM_STOP_PROFILER("rigid_euler_simulator::contactDetection");
 
   if (nactive_>0){
     if (dJv_.size()!=3*nactive_){
       CONSIM_START_PROFILER("rigid_euler_simulator::resizeVectorsAndMatrices");
-      dJv_.resize(3 * nactive_); dJv_.setZero();
-      Jc_.resize(3 * nactive_, nv); Jc_.setZero();
+      contactArena_.start();
+      contactArena_.bind(Jc_, 3 * nactive_, nv);
+      contactArena_.bind(dJv_, 3 * nactive_);
+      contactArena_.setZero();
+      stepStats_.resize_events += 1;
       CONSIM_STOP_PROFILER("rigid_euler_simulator::resizeVectorsAndMatrices");
     }
     
@@ -136,11 +149,13 @@ void RigidEulerSimulator::computeDynamics(const Eigen::VectorXd &tau, const Eige
   CONSIM_START_PROFILER("rigid_euler_simulator::forwardDynamics");
   const int nq = model_->nq, nv = model_->nv;
   computeContactForces(x, contacts_);
+  lapStepPhase(StepStats::CONTACTS);
   pinocchio::crba(*model_, *data_, x.head(nq));
   pinocchio::nonLinearEffects(*model_, *data_, x.head(nq), x.tail(nv));
   pinocchio::forwardDynamics(*model_, *data_, tau, Jc_, dJv_, regularization_);
   f.head(nv) = x.tail(nv);
   f.tail(nv) = data_-> ddq;
+  lapStepPhase(StepStats::DYNAMICS);
   CONSIM_STOP_PROFILER("rigid_euler_simulator::forwardDynamics");
 }
 
@@ -150,9 +165,10 @@ void RigidEulerSimulator::step(const Eigen::VectorXd &tau)
   if(!resetflag_){
     throw std::runtime_error("resetState() must be called first !");
   }
-  CONSIM_START_PROFILER("rigid_euler_simulator::step");
+  CONSIM_PROFILER_SCOPE("rigid_euler_simulator::step");
   assert(tau.size() == model_->nv);
 
+  startStepStats();
   avg_iteration_number_ = 0.0;
   x_.head(nq) = q_;
   x_.tail(nv) = v_;
@@ -175,6 +191,7 @@ void RigidEulerSimulator::step(const Eigen::VectorXd &tau)
       // integrate with RK2
       computeDynamics(tau, x_, f_);
       integrateState(*model_, x_, f_, sub_dt*0.5, xi_[1]);
+      lapStepPhase(StepStats::INTEGRATION);
       computeDynamics(tau, xi_[1], f_);
     }
     else if(integration_scheme_==4)
@@ -186,6 +203,7 @@ void RigidEulerSimulator::step(const Eigen::VectorXd &tau)
         computeDynamics(tau, xi_[j], fi_[j]);
         integrateState(*model_, xi_[0], fi_[j], sub_dt*rk_factors_a_[j+1], xi_[j+1]);
         f_.noalias() +=  fi_[j]*rk_factors_b_[j]; 
+        lapStepPhase(StepStats::INTEGRATION);
       }
       computeDynamics(tau, xi_[3], fi_[3]);
       f_.noalias() +=  fi_[3]*rk_factors_b_[3]; 
@@ -193,6 +211,8 @@ void RigidEulerSimulator::step(const Eigen::VectorXd &tau)
 
     integrateState(*model_, x_, f_, sub_dt, x_next_);
     x_ = x_next_;
+    lapStepPhase(StepStats::INTEGRATION);
+    endSubstepStats();
     // Eigen::internal::set_is_malloc_allowed(true);
     CONSIM_STOP_PROFILER("rigid_euler_simulator::substep");
     elapsedTime_ += sub_dt; 
@@ -201,7 +221,6 @@ void RigidEulerSimulator::step(const Eigen::VectorXd &tau)
   q_ = x_.head(nq);
   v_ = x_.tail(nv);
 
-  CONSIM_STOP_PROFILER("rigid_euler_simulator::step");
 }
 
 }  // namespace consim 
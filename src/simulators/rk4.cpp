@@ -55,7 +55,7 @@ EulerSimulator(model, data, dt, n_integration_steps, whichFD, EXPLICIT) {
   rk_factors_.push_back(1.); rk_factors_.push_back(.5); rk_factors_.push_back(.5); rk_factors_.push_back(1.); 
 }
 
-int RK4Simulator::computeContactForces(const Eigen::VectorXd &q, const Eigen::VectorXd &v, std::vector<ContactPoint*> &contacts) 
+int RK4Simulator::computeContactForces(const Eigen::VectorXd &q, const Eigen::VectorXd &v, ContactSet &contacts) 
 {
   // with RK4 the contact forces must be computed also for 3 intermediate states (2 in the middle of the time step and 1 at the end)
   // so we need to specify different values of q, v and contacts
@@ -70,11 +70,17 @@ void RK4Simulator::step(const Eigen::VectorXd &tau)
   if(!resetflag_){
     throw std::runtime_error("resetState() must be called first !");
   }
-  CONSIM_START_PROFILER("rk4_simulator::step");
+  CONSIM_PROFILER_SCOPE("rk4_simulator::step");
   assert(tau.size() == model_->nv);
+  startStepStats();
+  // allocate the contact snapshot only when contact points have been added
+  if (contactsCopy_.size() != contacts_.size()){
+    contactsCopy_ = contacts_;
+    stepStats_.resize_events += 1;
+  }
   for (int i = 0; i < n_integration_steps_; i++)
     {
-      // Eigen::internal::set_is_malloc_allowed(false);
+      setMallocAllowed(false);
       CONSIM_START_PROFILER("rk4_simulator::substep");
       // \brief add input control 
       tau_ += tau;
@@ -90,26 +96,24 @@ void RK4Simulator::step(const Eigen::VectorXd &tau)
 
       for(int j = 0; j<3; j++){
         forwardDynamics(tau_, dvi_[j], &qi_[j], &vi_[j]); 
+        lapStepPhase(StepStats::DYNAMICS);
         pinocchio::integrate(*model_,  q_, vi_[j] * sub_dt * rk_factors_[j+1], qi_[j+1]);
         vi_[j+1] = v_ +  dvi_[j] * sub_dt * rk_factors_[j+1]  ; 
 
         vMean_.noalias() +=  vi_[j]/(rk_factors_[j]*6) ; 
         dv_.noalias()    += dvi_[j]/(rk_factors_[j]*6) ; 
+        lapStepPhase(StepStats::INTEGRATION);
 
-        // create a copy of the current contacts
-        for(auto &cp: contactsCopy_){
-          delete cp;
-        }
-        contactsCopy_.clear();
-        for(auto &cp: contacts_){
-          contactsCopy_.push_back(new ContactPoint(*cp));
-        }
+        // restore the state of the current contacts in the preallocated snapshot
+        contactsCopy_.copyStateFrom(contacts_);
         // compute contact forces and add J^T*f to tau
         tau_ = tau;
         computeContactForces(qi_[j+1], vi_[j+1], contactsCopy_); 
+        lapStepPhase(StepStats::CONTACTS);
       }
 
       forwardDynamics(tau_, dvi_[3], &qi_[3], &vi_[3]); 
+      lapStepPhase(StepStats::DYNAMICS);
 
       vMean_.noalias() +=  vi_[3]/(rk_factors_[3]*6) ; 
       dv_.noalias()    += dvi_[3]/(rk_factors_[3]*6) ; 
@@ -117,16 +121,18 @@ void RK4Simulator::step(const Eigen::VectorXd &tau)
       v_ += dv_ * sub_dt;
       pinocchio::integrate(*model_, q_, vMean_ * sub_dt, qnext_);
       q_ = qnext_;
+      lapStepPhase(StepStats::INTEGRATION);
       
       // compute contact forces and add J^T*f to tau
       tau_.setZero();
       nactive_ = computeContactForces(q_, v_, contacts_);
+      lapStepPhase(StepStats::CONTACTS);
+      endSubstepStats();
 
-      // Eigen::internal::set_is_malloc_allowed(true);
+      setMallocAllowed(true);
       CONSIM_STOP_PROFILER("rk4_simulator::substep");
       elapsedTime_ += sub_dt; 
     }
-  CONSIM_STOP_PROFILER("rk4_simulator::step");
 }
 
 }  // namespace consim 
@@ -0,0 +1,183 @@
+
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+#include "consim/utils/lds-expmv.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace consim
+{
+
+namespace
+{
+  /*!< theta_m for m = 1, ..., 55 and double precision, from Al-Mohy and Higham (2011), Table 3.1 */
+  const int N_THETA = 35;
+  const int M_THETA[N_THETA] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
+                                21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 35, 40, 45, 50, 55};
+  const double THETA[N_THETA] = {2.29e-16, 2.58e-8, 1.39e-5, 3.40e-4, 2.40e-3, 9.07e-3, 2.38e-2, 5.00e-2,
+                                 8.96e-2, 1.44e-1, 2.14e-1, 3.00e-1, 4.00e-1, 5.14e-1, 6.41e-1, 7.81e-1,
+                                 9.31e-1, 1.09, 1.26, 1.44, 1.62, 1.82, 2.01, 2.22, 2.43, 2.64, 2.86, 3.08,
+                                 3.31, 3.54, 4.7, 6.0, 7.2, 8.5, 9.9};
+  const double TOLERANCE = 1.1102230246251565e-16; // 2^-53
+}
+
+
+LDSExpmv::LDSExpmv(): 
+n_(0), steps_(0), degree_(0), products_(0),
+M_(NULL, 0, 0), d_(NULL, 0), F_(NULL, 0, 0), B_(NULL, 0, 0), tmp_(NULL, 0, 0)
+{}
+
+
+void LDSExpmv::bindViews(int n)
+{
+  arena_.bind(M_, n+3, n+3);
+  arena_.bind(d_, n+3);
+  arena_.bind(F_, n+3, 3);
+  arena_.bind(B_, n+3, 3);
+  arena_.bind(tmp_, n+3, 3);
+}
+
+
+void LDSExpmv::resize(int n)
+{
+  n_ = n;
+  arena_.start(true);
+  bindViews(n);
+  arena_.reserve();
+  arena_.start();
+  bindViews(n);
+  arena_.setZero();
+  d_.setOnes();
+}
+
+
+void LDSExpmv::reserve(int n_max)
+{
+  const int n = n_;
+  resize(n_max);
+  resize(n);
+}
+
+
+void LDSExpmv::selectParameters(double norm)
+{
+  steps_ = 1;
+  degree_ = 0;
+  if(norm==0.0)
+    return;
+  double best_cost = -1.0;
+  for(int i=0; i<N_THETA; ++i)
+  {
+    const double s = std::max(1.0, std::ceil(norm/THETA[i]));
+    const double cost = M_THETA[i]*s;
+    if(best_cost<0.0 || cost<best_cost){
+      best_cost = cost;
+      steps_ = int(s);
+      degree_ = M_THETA[i];
+    }
+  }
+}
+
+
+void LDSExpmv::balance()
+{
+  // Osborne's iterations with powers of 2, as in LAPACK's dgebal (without permutations)
+  const int N = M_.rows();
+  d_.setOnes();
+  bool converged = false;
+  for(int sweep=0; sweep<10 && !converged; ++sweep)
+  {
+    converged = true;
+    for(int i=0; i<N; ++i)
+    {
+      double c = M_.col(i).cwiseAbs().sum() - std::abs(M_(i,i));
+      double r = M_.row(i).cwiseAbs().sum() - std::abs(M_(i,i));
+      if(c==0.0 || r==0.0)
+        continue;
+      const double s = c + r;
+      double f = 1.0;
+      while(c < 0.5*r){ c *= 4.0; r *= 0.25; f *= 2.0; }
+      while(c >= 2.0*r){ c *= 0.25; r *= 4.0; f *= 0.5; }
+      if(c + r < 0.95*s){
+        converged = false;
+        d_(i) *= f;
+        M_.col(i) *= f;
+        M_.row(i) /= f;
+      }
+    }
+  }
+}
+
+
+void LDSExpmv::compute(const Eigen::Ref<const Eigen::MatrixXd> &A, const Eigen::Ref<const Eigen::VectorXd> &a,
+                       const Eigen::Ref<const Eigen::VectorXd> &x0, double T,
+                       Eigen::Ref<Eigen::VectorXd> xT, Eigen::Ref<Eigen::VectorXd> intx, Eigen::Ref<Eigen::VectorXd> int2x)
+{
+  const int n = n_;
+  // a and x0 are scaled so that they do not dominate the norm of M (the result is linear in W)
+  const double normA = A.cwiseAbs().colwise().sum().maxCoeff();
+  const double normW = std::max(a.lpNorm<1>(), x0.lpNorm<1>());
+  const double c = normW > std::max(normA, 1.0) ? normW/std::max(normA, 1.0) : 1.0;
+
+  // shift by mu = trace(M)/(n+3) to reduce the norm, e^{M} = e^{mu} e^{M - mu I}
+  const double mu = T * A.trace() / (n+3);
+  M_.setZero();
+  M_.topLeftCorner(n, n) = T*A;
+  M_.col(n).head(n)   = (T/c)*a;
+  M_.col(n+1).head(n) = (T/c)*x0;
+  M_(n, n+1) = T;
+  M_(n+1, n+2) = T;
+  M_.diagonal().array() -= mu;
+  balance();
+
+  // e^{M} applied to [x0/c; 1; 0; 0], e_{n+1} and e_{n+2} gives x(T)/c, int x/c and int int x/c
+  F_.setZero();
+  F_.col(0).head(n) = x0/c;
+  F_(n, 0) = 1.0;
+  F_(n+1, 1) = 1.0;
+  F_(n+2, 2) = 1.0;
+  F_.array().colwise() /= d_.array();
+  B_ = F_;
+
+  selectParameters(M_.cwiseAbs().colwise().sum().maxCoeff());
+  products_ = 0;
+  const double eta = std::exp(mu/steps_);
+  for(int i=0; i<steps_; ++i)
+  {
+    double c1 = B_.cwiseAbs().rowwise().sum().maxCoeff();
+    for(int k=1; k<=degree_; ++k)
+    {
+      tmp_.noalias() = M_*B_;
+      B_ = tmp_ / double(steps_*k);
+      ++products_;
+      const double c2 = B_.cwiseAbs().rowwise().sum().maxCoeff();
+      F_ += B_;
+      if(c1+c2 <= TOLERANCE * F_.cwiseAbs().rowwise().sum().maxCoeff())
+        break;
+      c1 = c2;
+    }
+    F_ *= eta;
+    B_ = F_;
+  }
+
+  F_.array().colwise() *= d_.array();
+  xT    = c * F_.col(0).head(n);
+  intx  = c * F_.col(1).head(n);
+  int2x = c * F_.col(2).head(n);
+}
+
+} // namespace consim
@@ -0,0 +1,126 @@
+
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+#include "consim/utils/lds-modal.hpp"
+
+#include <cmath>
+
+namespace consim
+{
+
+LDSModal::LDSModal(): 
+n_(0), beta_(0.0), sqrtK_(NULL, 0), S_(NULL, 0, 0),
+G_(NULL, 0, 0), H_(NULL, 0, 0), R_(NULL, 0, 0), O_(NULL, 0, 0)
+{}
+
+
+void LDSModal::bindViews(int n)
+{
+  arena_.bind(sqrtK_, n);
+  arena_.bind(S_, n, n);
+  arena_.bind(G_, n, 4);
+  arena_.bind(H_, n, 4);
+  arena_.bind(R_, n, 6);
+  arena_.bind(O_, n, 6);
+}
+
+
+void LDSModal::resize(int n)
+{
+  n_ = n;
+  arena_.start(true);
+  bindViews(n);
+  arena_.reserve();
+  arena_.start();
+  bindViews(n);
+  arena_.setZero();
+  sqrtK_.setOnes();
+  modes_.resize(n);
+}
+
+
+void LDSModal::reserve(int n_max)
+{
+  const int n = n_;
+  resize(n_max);
+  resize(n);
+}
+
+
+bool LDSModal::compute(const Eigen::Ref<const Eigen::MatrixXd> &Y, const Eigen::Ref<const Eigen::VectorXd> &K,
+                       const Eigen::Ref<const Eigen::VectorXd> &B, double T)
+{
+  if(n_==0 || K.minCoeff() <= 0.0)
+    return false;
+  beta_ = B(0)/K(0);
+  for(int i=1; i<n_; ++i)
+    if(std::abs(B(i) - beta_*K(i)) > 1e-12*std::abs(B(i)))
+      return false;
+
+  sqrtK_ = K.cwiseSqrt();
+  S_ = sqrtK_.asDiagonal() * Y * sqrtK_.asDiagonal();
+  eig_.compute(S_);
+  if(eig_.info()!=Eigen::Success)
+    return false;
+
+  // the top block row of e^{T [Am, I, 0, 0; 0, 0, I, 0; 0, 0, 0, I; 0, 0, 0, 0]} is [E, F1, F2, F3]
+  for(int i=0; i<n_; ++i)
+  {
+    const double l = eig_.eigenvalues()(i);
+    Mmode_.setZero();
+    Mmode_(0, 1) = T;
+    Mmode_(1, 0) = -T*l;
+    Mmode_(1, 1) = -T*beta_*l;
+    Mmode_.block<6,6>(0, 2).setIdentity();
+    Mmode_.block<6,6>(0, 2) *= T;
+    expm_.compute(Mmode_, Emode_);
+    modes_[i] = Emode_.topRows<2>();
+  }
+  return true;
+}
+
+
+void LDSModal::apply(const Eigen::Ref<const Eigen::VectorXd> &a, const Eigen::Ref<const Eigen::VectorXd> &x0,
+                     Eigen::Ref<Eigen::VectorXd> xT, Eigen::Ref<Eigen::VectorXd> intx, Eigen::Ref<Eigen::VectorXd> int2x)
+{
+  const int n = n_;
+  G_.col(0) = sqrtK_.cwiseProduct(x0.head(n));
+  G_.col(1) = sqrtK_.cwiseProduct(x0.tail(n));
+  G_.col(2) = sqrtK_.cwiseProduct(a.head(n));
+  G_.col(3) = sqrtK_.cwiseProduct(a.tail(n));
+  H_.noalias() = eig_.eigenvectors().transpose() * G_;
+
+  for(int i=0; i<n; ++i)
+  {
+    const ModeOperators &m = modes_[i];
+    const Eigen::Vector2d s0(H_(i,0), H_(i,1));
+    const Eigen::Vector2d ai(H_(i,2), H_(i,3));
+    R_.block<1,2>(i, 0) = (m.block<2,2>(0,0)*s0 + m.block<2,2>(0,2)*ai).transpose();
+    R_.block<1,2>(i, 2) = (m.block<2,2>(0,2)*s0 + m.block<2,2>(0,4)*ai).transpose();
+    R_.block<1,2>(i, 4) = (m.block<2,2>(0,4)*s0 + m.block<2,2>(0,6)*ai).transpose();
+  }
+
+  O_.noalias() = eig_.eigenvectors() * R_;
+  O_.array().colwise() /= sqrtK_.array();
+  xT.head(n)    = O_.col(0);
+  xT.tail(n)    = O_.col(1);
+  intx.head(n)  = O_.col(2);
+  intx.tail(n)  = O_.col(3);
+  int2x.head(n) = O_.col(4);
+  int2x.tail(n) = O_.col(5);
+}
+
+} // namespace consim
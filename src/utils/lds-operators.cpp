@@ -0,0 +1,128 @@
+
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+#include "consim/utils/lds-operators.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+namespace consim
+{
+
+LDSIntegralOperators::LDSIntegralOperators(): 
+n_(0), squarings_(0),
+E_(NULL, 0, 0), F1_(NULL, 0, 0), F2_(NULL, 0, 0), F3_(NULL, 0, 0),
+X_(NULL, 0, 0), term_(NULL, 0, 0), tmp_(NULL, 0, 0)
+{}
+
+
+void LDSIntegralOperators::bindViews(int n)
+{
+  arena_.bind(E_, n, n);
+  arena_.bind(F1_, n, n);
+  arena_.bind(F2_, n, n);
+  arena_.bind(F3_, n, n);
+  arena_.bind(X_, n, n);
+  arena_.bind(term_, n, n);
+  arena_.bind(tmp_, n, n);
+}
+
+
+void LDSIntegralOperators::resize(int n)
+{
+  n_ = n;
+  arena_.start(true);
+  bindViews(n);
+  arena_.reserve();
+  arena_.start();
+  bindViews(n);
+  arena_.setZero();
+  E_.setIdentity();
+}
+
+
+void LDSIntegralOperators::reserve(int n_max)
+{
+  const int n = n_;
+  resize(n_max);
+  resize(n);
+}
+
+
+void LDSIntegralOperators::compute(const Eigen::Ref<const Eigen::MatrixXd> &A, double T)
+{
+  // the Taylor series is truncated on an interval short enough to have ||t A|| <= 1/2
+  const double theta = 0.5;
+  const double normA = A.cwiseAbs().colwise().sum().maxCoeff();
+  squarings_ = normA*T > theta ? int(std::ceil(std::log2(normA*T/theta))) : 0;
+  double t = std::ldexp(T, -squarings_);
+
+  /**
+   * With term_k = (tA)^k / k!
+   *    E = sum term_k,  F1 = t sum term_k/(k+1),  F2 = t^2 sum term_k/((k+1)(k+2)), ...
+   */
+  X_ = t*A;
+  term_.setIdentity();
+  E_.setIdentity();
+  F1_.setIdentity();
+  F2_.setIdentity(); F2_ *= 0.5;
+  F3_.setIdentity(); F3_ *= 1.0/6.0;
+  const double eps = std::numeric_limits<double>::epsilon();
+  for(int k=1; k<30; ++k)
+  {
+    tmp_.noalias() = term_*X_;
+    term_ = tmp_ / k;
+    E_  += term_;
+    F1_ += term_ / (k+1);
+    F2_ += term_ / ((k+1)*(k+2));
+    F3_ += term_ / ((k+1)*(k+2)*(k+3));
+    if(term_.cwiseAbs().colwise().sum().maxCoeff() <= eps)
+      break;
+  }
+  F1_ *= t;
+  F2_ *= t*t;
+  F3_ *= t*t*t;
+
+  // from [0, t] to [0, 2t]
+  for(int i=0; i<squarings_; ++i)
+  {
+    tmp_.noalias() = E_*F3_;
+    F3_ += tmp_ + (0.5*t*t)*F1_ + t*F2_;
+    tmp_.noalias() = E_*F2_;
+    F2_ += tmp_ + t*F1_;
+    tmp_.noalias() = E_*F1_;
+    F1_ += tmp_;
+    tmp_.noalias() = E_*E_;
+    E_ = tmp_;
+    t *= 2.0;
+  }
+}
+
+
+void LDSIntegralOperators::apply(const Eigen::Ref<const Eigen::VectorXd> &a, const Eigen::Ref<const Eigen::VectorXd> &x0,
+                                 Eigen::Ref<Eigen::VectorXd> xT, Eigen::Ref<Eigen::VectorXd> intx, 
+                                 Eigen::Ref<Eigen::VectorXd> int2x) const
+{
+  xT.noalias()    = E_*x0;
+  xT.noalias()   += F1_*a;
+  intx.noalias()  = F1_*x0;
+  intx.noalias() += F2_*a;
+  int2x.noalias()  = F2_*x0;
+  int2x.noalias() += F3_*a;
+}
+
+} // namespace consim
@@ -0,0 +1,376 @@
+
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+
+#include "consim/utils/profiler.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+
+namespace consim
+{
+
+namespace
+{
+  std::mutex registry_mutex;
+  std::string probe_names[Profiler::MAX_PROBES];
+  std::atomic<int> n_probes(0);
+}
+
+std::atomic<bool> Profiler::enabled_(true);
+std::atomic<bool> Profiler::tracing_(false);
+std::size_t Profiler::trace_capacity_ = 0;
+uint64_t Profiler::trace_origin_ = 0;
+std::atomic<int> Profiler::parents_[Profiler::MAX_PROBES];
+thread_local Profiler::ThreadData *Profiler::thread_data_ = NULL;
+
+std::vector<std::unique_ptr<Profiler::ThreadData> > &Profiler::threadRegistry()
+{
+  static std::vector<std::unique_ptr<ThreadData> > registry;
+  return registry;
+}
+
+
+Profiler::ThreadData::ThreadData(int index): depth(0), index(index), in_use(true), trace_capacity(0), trace_head(0)
+{
+  for(int i=0; i<MAX_PROBES; ++i){
+    stats[i].total = 0;
+    stats[i].count = 0;
+    stats[i].min = std::numeric_limits<uint64_t>::max();
+    stats[i].max = 0;
+    for(int j=0; j<Histogram::N_BUCKETS; ++j)
+      histograms[i][j] = 0;
+  }
+}
+
+
+int Profiler::registerProbe(const char *name)
+{
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  const int n = n_probes.load();
+  for(int i=0; i<n; ++i)
+    if(probe_names[i]==name)
+      return i;
+  if(n>=MAX_PROBES)
+    return -1;
+  probe_names[n] = name;
+  parents_[n] = -2;  // not started yet
+  n_probes.store(n+1);
+  return n;
+}
+
+
+int Profiler::findProbe(const std::string &name)
+{
+  const int n = n_probes.load();
+  for(int i=0; i<n; ++i)
+    if(probe_names[i]==name)
+      return i;
+  return -1;
+}
+
+
+std::vector<std::string> Profiler::getProbeNames()
+{
+  const int n = n_probes.load();
+  return std::vector<std::string>(probe_names, probe_names+n);
+}
+
+
+Profiler::ThreadData *Profiler::registerThread()
+{
+  // constructed once per thread, its destructor runs when the thread exits
+  static thread_local ThreadReleaser releaser;
+  (void) releaser;
+
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  // reuse the slot of a thread that exited (its statistics are kept), or allocate a new one
+  ThreadData *td = NULL;
+  for(auto &slot : threadRegistry()){
+    if(!slot->in_use){
+      td = slot.get();
+      td->in_use = true;
+      td->depth = 0;
+      break;
+    }
+  }
+  if(td==NULL){
+    td = new ThreadData((int) threadRegistry().size());
+    threadRegistry().emplace_back(td);
+  }
+  if(td->trace_capacity!=trace_capacity_){
+    td->trace.reset(trace_capacity_>0 ? new TraceEvent[trace_capacity_] : NULL);
+    td->trace_capacity = trace_capacity_;
+    td->trace_head.store(0);
+  }
+  return td;
+}
+
+
+Profiler::ThreadReleaser::~ThreadReleaser()
+{
+  if(thread_data_==NULL)
+    return;
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  thread_data_->in_use = false;
+  thread_data_ = NULL;
+}
+
+
+void Profiler::resetAll()
+{
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  for(auto &td : threadRegistry()){
+    for(int i=0; i<MAX_PROBES; ++i){
+      td->stats[i].total = 0;
+      td->stats[i].count = 0;
+      td->stats[i].min = std::numeric_limits<uint64_t>::max();
+      td->stats[i].max = 0;
+      for(int j=0; j<Histogram::N_BUCKETS; ++j)
+        td->histograms[i][j] = 0;
+    }
+  }
+}
+
+
+Profiler::Totals Profiler::aggregate(int id)
+{
+  Totals t = {0, 0, std::numeric_limits<uint64_t>::max(), 0};
+  if(id<0) return t;
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  for(auto &td : threadRegistry()){
+    const ProbeStats &s = td->stats[id];
+    t.total += s.total.load(std::memory_order_relaxed);
+    t.count += s.count.load(std::memory_order_relaxed);
+    t.min = std::min(t.min, s.min.load(std::memory_order_relaxed));
+    t.max = std::max(t.max, s.max.load(std::memory_order_relaxed));
+  }
+  return t;
+}
+
+
+double Profiler::secondsPerTick()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  // the time stamp counter is calibrated once against steady_clock over 10 ms
+  static const double seconds_per_tick = []()
+  {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point t0 = Clock::now();
+    const uint64_t tsc0 = now();
+    Clock::time_point t1 = t0;
+    while(t1 - t0 < std::chrono::milliseconds(10))
+      t1 = Clock::now();
+    const uint64_t tsc1 = now();
+    return std::chrono::duration<double>(t1 - t0).count() / (double)(tsc1 - tsc0);
+  }();
+  return seconds_per_tick;
+#else
+  return (double) std::chrono::steady_clock::period::num / std::chrono::steady_clock::period::den;
+#endif
+}
+
+
+double Profiler::getTotalTime(const std::string &name)
+{
+  const Totals t = aggregate(findProbe(name));
+  return t.total * secondsPerTick();
+}
+
+
+double Profiler::getAverageTime(const std::string &name)
+{
+  const Totals t = aggregate(findProbe(name));
+  return t.count>0 ? t.total * secondsPerTick() / t.count : 0.0;
+}
+
+
+double Profiler::getMinTime(const std::string &name)
+{
+  const Totals t = aggregate(findProbe(name));
+  return t.count>0 ? t.min * secondsPerTick() : 0.0;
+}
+
+
+double Profiler::getMaxTime(const std::string &name)
+{
+  const Totals t = aggregate(findProbe(name));
+  return t.max * secondsPerTick();
+}
+
+
+uint64_t Profiler::getCount(const std::string &name)
+{
+  return aggregate(findProbe(name)).count;
+}
+
+
+double Profiler::getPercentileTime(const std::string &name, double p)
+{
+  const int id = findProbe(name);
+  if(id<0) return 0.0;
+  uint64_t counts[Histogram::N_BUCKETS] = {0};
+  uint64_t total = 0;
+  uint64_t max = 0;
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for(auto &td : threadRegistry()){
+      for(int j=0; j<Histogram::N_BUCKETS; ++j){
+        const uint64_t c = td->histograms[id][j].load(std::memory_order_relaxed);
+        counts[j] += c;
+        total += c;
+      }
+      max = std::max(max, td->stats[id].max.load(std::memory_order_relaxed));
+    }
+  }
+  // the middle of the last bucket may exceed the largest measurement
+  return std::min(Histogram::percentile(counts, total, p), max) * secondsPerTick();
+}
+
+
+void Profiler::reportProbe(int id, int level, int precision, std::ostream &output)
+{
+  const Totals t = aggregate(id);
+  if(t.count>0){
+    const double ms = 1e3 * secondsPerTick();
+    output << std::string(2*level, ' ') << std::setw(60-2*level) << std::left << probe_names[id];
+    output << std::fixed << std::setprecision(precision);
+    output << std::setw(10) << t.min*ms << " ";
+    output << std::setw(10) << t.total*ms/t.count << " ";
+    output << std::setw(10) << t.max*ms << " ";
+    output << std::setw(10) << 1e3*getPercentileTime(probe_names[id], 50.0) << " ";
+    output << std::setw(10) << 1e3*getPercentileTime(probe_names[id], 90.0) << " ";
+    output << std::setw(10) << 1e3*getPercentileTime(probe_names[id], 99.0) << " ";
+    output << std::setw(10) << 1e3*getPercentileTime(probe_names[id], 99.9) << " ";
+    output << std::setw(10) << t.count << " ";
+    output << std::setw(10) << t.total*ms << std::endl;
+  }
+  const int n = n_probes.load();
+  for(int i=0; i<n; ++i)
+    if(i!=id && parents_[i].load(std::memory_order_relaxed)==id)
+      reportProbe(i, level+1, precision, output);
+}
+
+
+void Profiler::report(int precision, std::ostream &output)
+{
+  output << "\n" << std::setw(60) << std::left << "*** PROFILING RESULTS [ms] ";
+  output << std::setw(10) << "min" << " ";
+  output << std::setw(10) << "avg" << " ";
+  output << std::setw(10) << "max" << " ";
+  output << std::setw(10) << "p50" << " ";
+  output << std::setw(10) << "p90" << " ";
+  output << std::setw(10) << "p99" << " ";
+  output << std::setw(10) << "p99.9" << " ";
+  output << std::setw(10) << "nSamples" << " ";
+  output << std::setw(10) << "totalTime" << " ***\n";
+  const int n = n_probes.load();
+  for(int i=0; i<n; ++i){
+    const int parent = parents_[i].load(std::memory_order_relaxed);
+    if(parent<0)
+      reportProbe(i, 0, precision, output);
+  }
+}
+
+void Profiler::startTrace(std::size_t events_per_thread)
+{
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  tracing_.store(false);
+  trace_capacity_ = events_per_thread;
+  for(auto &td : threadRegistry()){
+    if(td->trace_capacity!=trace_capacity_){
+      td->trace.reset(trace_capacity_>0 ? new TraceEvent[trace_capacity_] : NULL);
+      td->trace_capacity = trace_capacity_;
+    }
+    td->trace_head.store(0);
+  }
+  trace_origin_ = now();
+  tracing_.store(events_per_thread>0);
+}
+
+
+void Profiler::stopTrace()
+{
+  tracing_.store(false);
+}
+
+
+namespace
+{
+  void writeJsonString(std::ostream &output, const std::string &s)
+  {
+    output << '"';
+    for(char c : s){
+      if(c=='"' || c=='\\')
+        output << '\\';
+      output << c;
+    }
+    output << '"';
+  }
+}
+
+
+void Profiler::writeTrace(std::ostream &output)
+{
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  const double us = 1e6 * secondsPerTick();
+  bool first = true;
+  output << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+  for(auto &td : threadRegistry()){
+    const uint64_t head = td->trace_head.load(std::memory_order_acquire);
+    if(td->trace_capacity==0 || head==0)
+      continue;
+    output << (first ? "\n" : ",\n");
+    first = false;
+    output << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << td->index;
+    output << ", \"args\": {\"name\": \"thread " << td->index << "\"}}";
+
+    // if the buffer wrapped around, the end events whose begin was overwritten are skipped
+    const uint64_t begin = head > td->trace_capacity ? head - td->trace_capacity : 0;
+    int depth = 0;
+    output << std::fixed << std::setprecision(3);
+    for(uint64_t i=begin; i<head; ++i){
+      const TraceEvent &e = td->trace[i % td->trace_capacity];
+      if(e.phase=='E'){
+        if(depth==0) continue;
+        --depth;
+      }
+      else
+        ++depth;
+      output << ",\n{\"name\": ";
+      writeJsonString(output, probe_names[e.id]);
+      output << ", \"ph\": \"" << e.phase << "\", \"pid\": 0, \"tid\": " << td->index;
+      output << ", \"ts\": " << (e.time>=trace_origin_ ? (e.time - trace_origin_)*us : 0.0) << "}";
+    }
+  }
+  output << "\n]}\n";
+}
+
+
+void Profiler::writeTrace(const std::string &filename)
+{
+  std::ofstream output(filename.c_str());
+  if(!output.is_open())
+    throw std::runtime_error("Cannot open file "+filename+" to write the profiler trace");
+  writeTrace(output);
+}
+
+} // namespace consim
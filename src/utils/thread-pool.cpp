@@ -0,0 +1,163 @@
+
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+#include "consim/utils/thread-pool.hpp"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace consim
+{
+
+ThreadPool::ThreadPool(int n_threads, bool pin_threads):
+n_threads_(n_threads>0 ? n_threads : std::max(1, (int)std::thread::hardware_concurrency()))
+{
+  ranges_.reset(new WorkRange[n_threads_]);
+  for (int k=0; k<n_threads_; ++k){
+    ranges_[k].next = 0;
+    ranges_[k].end = 0;
+  }
+
+  // the calling thread acts as worker 0 and is left unpinned
+  threads_.reserve(n_threads_-1);
+  for (int k=1; k<n_threads_; ++k){
+    threads_.emplace_back([this, k, pin_threads](){
+      if(pin_threads)
+        pinCurrentThread(k);
+      workerLoop(k);
+    });
+  }
+}
+
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_cv_.notify_all();
+  for (auto &t : threads_)
+    t.join();
+}
+
+
+void ThreadPool::pinCurrentThread(int core)
+{
+#ifdef __linux__
+  const int n_cores = std::max(1, (int)std::thread::hardware_concurrency());
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(core % n_cores, &cpuset);
+  pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+#else
+  (void)core;
+#endif
+}
+
+
+void ThreadPool::parallelFor(int n, const Task &task)
+{
+  if(n<=0)
+    return;
+
+  // one contiguous chunk per worker, the first (n % n_threads_) chunks get one more index
+  const int chunk = n / n_threads_;
+  const int rest = n % n_threads_;
+  int begin = 0;
+  for (int k=0; k<n_threads_; ++k){
+    const int size = chunk + (k<rest ? 1 : 0);
+    ranges_[k].end = begin + size;
+    ranges_[k].next.store(begin, std::memory_order_relaxed);
+    begin += size;
+  }
+
+  error_ = nullptr;
+  if(n_threads_==1){
+    task_ = &task;
+    runWorker(0);
+    task_ = nullptr;
+  }
+  else{
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      task_ = &task;
+      busy_workers_ = n_threads_-1;
+      ++generation_;
+    }
+    start_cv_.notify_all();
+
+    runWorker(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this](){return busy_workers_==0;});
+    task_ = nullptr;
+  }
+
+
+  if(error_)
+    std::rethrow_exception(error_);
+}
+
+
+void ThreadPool::workerLoop(int worker)
+{
+  unsigned long last_generation = 0;
+  while(true){
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_cv_.wait(lock, [this, last_generation](){return stop_ || generation_!=last_generation;});
+      if(stop_)
+        return;
+      last_generation = generation_;
+    }
+
+    runWorker(worker);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --busy_workers_;
+    }
+    done_cv_.notify_one();
+  }
+}
+
+
+void ThreadPool::runWorker(int worker)
+{
+  // first consume the own chunk, then steal from the other workers
+  for (int k=0; k<n_threads_; ++k){
+    WorkRange &range = ranges_[(worker+k) % n_threads_];
+    int i = range.next.fetch_add(1, std::memory_order_relaxed);
+    while(i < range.end){
+      try{
+        (*task_)(i, worker);
+      }
+      catch(...){
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(!error_)
+          error_ = std::current_exception();
+      }
+      i = range.next.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+}
+
+} // namespace consim
@@ -0,0 +1,236 @@
+
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+
+/**
+ * Checks that the steps of the simulators (RK4, implicit Euler, and a batch of RK4 simulators stepped in 
+ * parallel) do not allocate once their buffers have been sized by the first step, with active contacts 
+ * and across touchdowns. The allocations are counted by wrapping malloc (glibc only), so that the check 
+ * does not depend on the assertions of Eigen's EIGEN_RUNTIME_NO_MALLOC being compiled in the library; 
+ * the test is built with EIGEN_RUNTIME_NO_MALLOC and without NDEBUG, so that Eigen's assertion also 
+ * fires if the step allocates in an Eigen expression.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <Eigen/Core>
+
+#include "consim/simulators/common.hpp"
+#include "consim/simulators/rk4.hpp"
+#include "consim/simulators/implicit_euler.hpp"
+#include "consim/simulators/batch.hpp"
+#include "consim/utils/profiler.hpp"
+
+#include "test_utils.hpp"
+
+using namespace consim;
+using namespace consim::test;
+
+#ifdef __GLIBC__
+namespace
+{
+  // malloc is also called by the workers of BatchSimulator
+  std::atomic<bool> count_allocations(false);
+  std::atomic<long> allocations(0);
+}
+
+extern "C"
+{
+  void *__libc_malloc(size_t size);
+  void *__libc_calloc(size_t n, size_t size);
+  void *__libc_realloc(void *ptr, size_t size);
+
+  void *malloc(size_t size)
+  {
+    if(count_allocations)
+      ++allocations;
+    return __libc_malloc(size);
+  }
+
+  void *calloc(size_t n, size_t size)
+  {
+    if(count_allocations)
+      ++allocations;
+    return __libc_calloc(n, size);
+  }
+
+  void *realloc(void *ptr, size_t size)
+  {
+    if(count_allocations)
+      ++allocations;
+    return __libc_realloc(ptr, size);
+  }
+}
+#endif
+
+namespace
+{
+  /**
+   * Runs n_steps steps of the simulator under the standing controller, the first unchecked_steps are not 
+   * checked since they size the buffers. Returns the number of allocations of the other steps (0 without 
+   * glibc) and checks that some contacts were active. The factorizations of the Newton system of the 
+   * checked steps are added to jacobian_updates (ImplicitEulerSimulator).
+   */
+  long countStepAllocations(AbstractSimulator &sim, const TestRobot &robot, int n_steps, 
+                            int *jacobian_updates=NULL, int unchecked_steps=1)
+  {
+    Eigen::VectorXd tau = Eigen::VectorXd::Zero(robot.model.nv);
+    int max_active = 0;
+    long n = 0;
+    for(int i=0; i<n_steps; ++i){
+      standingTorques(robot, sim.get_q(), sim.get_v(), tau);
+#ifdef __GLIBC__
+      allocations = 0;
+      count_allocations = i>=unchecked_steps;
+#endif
+      sim.step(tau);
+#ifdef __GLIBC__
+      count_allocations = false;
+      n += allocations;
+#endif
+      max_active = std::max(max_active, sim.getStepStats().active_contacts);
+      if(jacobian_updates!=NULL && i>=unchecked_steps)
+        *jacobian_updates += sim.getStepStats().jacobian_updates;
+    }
+    BOOST_CHECK(max_active > 0);
+    BOOST_CHECK(sim.get_v().allFinite());
+    return n;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(BOOST_TEST_MODULE)
+
+BOOST_AUTO_TEST_CASE(test_malloc_checks_enabled)
+{
+#ifdef EIGEN_RUNTIME_NO_MALLOC
+  // the simulators must actually switch Eigen's flag, otherwise the assertions check nothing
+  setMallocAllowed(false);
+  BOOST_CHECK(!Eigen::internal::is_malloc_allowed());
+  setMallocAllowed(true);
+  BOOST_CHECK(Eigen::internal::is_malloc_allowed());
+#else
+  BOOST_TEST_MESSAGE("EIGEN_RUNTIME_NO_MALLOC is not defined, only the malloc counter checks the steps");
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(test_rk4_step_standing)
+{
+  const TestRobot robot = buildQuadruped();
+  pinocchio::Data data(robot.model);
+  RK4Simulator sim(robot.model, data, 1e-3, 4, 3);
+  setupStanding(sim, robot);
+  BOOST_CHECK_EQUAL(countStepAllocations(sim, robot, 200), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_rk4_step_touchdown)
+{
+  // dropped from 1 cm: the feet touch the floor (and possibly bounce) during the test
+  TestRobot robot = buildQuadruped();
+  robot.q0(2) += 1e-2;
+  pinocchio::Data data(robot.model);
+  RK4Simulator sim(robot.model, data, 1e-3, 4, 3);
+  setupStanding(sim, robot);
+  BOOST_CHECK(sim.get_contact_forces().isZero());
+  BOOST_CHECK_EQUAL(countStepAllocations(sim, robot, 300), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_implicit_euler_newton)
+{
+  // structured (Schur complement) and dense solves of the Newton system, with the 4 feet on the floor
+  const bool structured[] = {true, false};
+  for(bool s : structured){
+    const TestRobot robot = buildQuadruped();
+    pinocchio::Data data(robot.model);
+    ImplicitEulerSimulator sim(robot.model, data, 1e-3, 2);
+    sim.set_use_structured_newton_solve(s);
+    setupStanding(sim, robot);
+    int jacobian_updates = 0;
+    BOOST_CHECK_EQUAL(countStepAllocations(sim, robot, 100, &jacobian_updates), 0);
+    BOOST_CHECK(jacobian_updates > 0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_implicit_euler_reused_jacobian)
+{
+  // with the chord method the factorization is recomputed only when it is invalidated (here by 
+  // changing an option of the Jacobian) or when the convergence stalls: these re-factorizations 
+  // must not allocate either
+  const TestRobot robot = buildQuadruped();
+  pinocchio::Data data(robot.model);
+  ImplicitEulerSimulator sim(robot.model, data, 1e-3, 2);
+  sim.set_reuse_jacobian(true);
+  setupStanding(sim, robot);
+  BOOST_CHECK_EQUAL(countStepAllocations(sim, robot, 20), 0);
+  for(int i=0; i<5; ++i){
+    sim.set_use_finite_differences_dynamics(false);
+    int jacobian_updates = 0;
+    BOOST_CHECK_EQUAL(countStepAllocations(sim, robot, 20, &jacobian_updates, 0), 0);
+    BOOST_CHECK(jacobian_updates > 0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_parallel_step)
+{
+  // the workers step the environments with Eigen's no-malloc checks suspended (the flag is process-wide), 
+  // so only the malloc counter can tell that the parallel steps do not allocate. The robots are dropped 
+  // from different heights, so that their feet touch down at different steps.
+  const TestRobot robot = buildQuadruped();
+  const int n_envs = 8;
+  BatchSimulator batch(robot.model, n_envs, [](const pinocchio::Model &model, pinocchio::Data &data){
+    return new RK4Simulator(model, data, 1e-3, 4, 3);
+  });
+  batch.addObject(getFloor());
+  for(const auto &name : robot.contact_frames)
+    batch.addContactPoint(name, robot.model.getFrameId(name), true);
+  batch.setNumberOfThreads(2, false);
+
+  Eigen::MatrixXd q0 = robot.q0.replicate(1, n_envs);
+  q0.row(2).array() += Eigen::ArrayXd::LinSpaced(n_envs, 0.0, 1e-2).transpose();
+  batch.resetState(q0, Eigen::MatrixXd::Zero(robot.model.nv, n_envs), true);
+
+  // the profiler allocates the data of a thread at its first probe, which can be at any step for a 
+  // worker that did not get an environment before
+  const bool profiling = Profiler::isEnabled();
+  Profiler::setEnabled(false);
+  Eigen::MatrixXd tau = Eigen::MatrixXd::Zero(robot.model.nv, n_envs);
+  Eigen::VectorXd tau_i(robot.model.nv);
+  int max_active = 0;
+  long n = 0;
+  for(int i=0; i<100; ++i){
+    for(int k=0; k<n_envs; ++k){
+      standingTorques(robot, batch.get_q().col(k), batch.get_v().col(k), tau_i);
+      tau.col(k) = tau_i;
+    }
+#ifdef __GLIBC__
+    allocations = 0;
+    count_allocations = i>0;
+#endif
+    batch.step(tau);
+#ifdef __GLIBC__
+    count_allocations = false;
+    n += allocations;
+#endif
+    for(int k=0; k<n_envs; ++k)
+      max_active = std::max(max_active, batch.getSimulator(k).getStepStats().active_contacts);
+  }
+  Profiler::setEnabled(profiling);
+  BOOST_CHECK_EQUAL(n, 0);
+  BOOST_CHECK(max_active > 0);
+  BOOST_CHECK(batch.get_v().allFinite());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
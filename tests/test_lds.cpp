@@ -0,0 +1,177 @@
+
+//
+//  Copyright (c) 2020-2021 UNITN, NYU
+//
+//  This file is part of consim
+//  consim is free software: you can redistribute it
+//  and/or modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation, either version
+//  3 of the License, or (at your option) any later version.
+//  consim is distributed in the hope that it will be
+//  useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+//  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+//  General Lesser Public License for more details. You should have
+//  received a copy of the GNU Lesser General Public License along with
+//  consim If not, see
+//  <http://www.gnu.org/licenses/>.
+
+/**
+ * Checks the LDS integrators of the exponential simulator (LDSKernel, LDSIntegralOperators, LDSExpmv 
+ * and LDSModal) against expokit::LDSUtility::ComputeIntegrals, on contact LDS with 1 to 8 contacts
+ *    d/dt [p; v] = [0, I; -Y K, -Y B] [p; v] + a
+ * with Y symmetric positive definite (as the Delassus matrix Upsilon) and B = beta*K.
+ * expokit does not return x(T), which is checked as x0 + A int x + T a.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>
+#include <Eigen/Core>
+#include <LDSUtility.hpp>
+
+#include "consim/utils/lds-kernel.hpp"
+#include "consim/utils/lds-operators.hpp"
+#include "consim/utils/lds-expmv.hpp"
+#include "consim/utils/lds-modal.hpp"
+
+using namespace consim;
+using namespace Eigen;
+
+namespace
+{
+  const int MAX_CONTACTS = 8;
+  const double TIME_STEPS[] = {1e-4, 1e-3, 1e-2};
+  const double TOLERANCE = 1e-8;  /*!< relative to the largest element of the expokit result */
+
+  struct ContactLDS
+  {
+    MatrixXd Y, A;
+    VectorXd K, B, a, x0;
+    double T;
+    VectorXd xT, intx, int2x;  /*!< expokit results */
+  };
+
+  /**
+   * Random contact LDS with the stiffness and damping used in the scripts (K = 1e5, B = 3e2)
+   */
+  ContactLDS makeContactLDS(int n_contacts, double T)
+  {
+    const int n = 3*n_contacts, nv = 18;
+    ContactLDS lds;
+    const MatrixXd Jc = MatrixXd::Random(n, nv);
+    lds.Y = Jc * Jc.transpose() / nv;
+    lds.Y.diagonal().array() += 0.1;
+    lds.K = VectorXd::Constant(n, 1e5);
+    lds.B = VectorXd::Constant(n, 3e2);
+    lds.A = MatrixXd::Zero(2*n, 2*n);
+    lds.A.topRightCorner(n, n).setIdentity();
+    lds.A.bottomLeftCorner(n, n) = -lds.Y * lds.K.asDiagonal();
+    lds.A.bottomRightCorner(n, n) = -lds.Y * lds.B.asDiagonal();
+    lds.a = VectorXd::Zero(2*n);
+    lds.a.tail(n) = 10.0 * VectorXd::Random(n);
+    lds.x0.resize(2*n);
+    lds.x0.head(n) = 1e-4 * VectorXd::Random(n);
+    lds.x0.tail(n) = 1e-2 * VectorXd::Random(n);
+    lds.T = T;
+
+    expokit::LDSUtility<double, Dynamic> expokit_lds;
+    expokit_lds.setMaxMultiplications(100);
+    expokit_lds.resize(2*n);
+    lds.intx.resize(2*n);
+    lds.int2x.resize(2*n);
+    expokit_lds.ComputeIntegrals(lds.A, lds.a, lds.x0, T, lds.intx, lds.int2x);
+    lds.xT = lds.x0 + lds.A * lds.intx + T * lds.a;
+    return lds;
+  }
+
+  void checkResult(const ContactLDS &lds, const VectorXd &xT, const VectorXd &intx, const VectorXd &int2x)
+  {
+    BOOST_CHECK_LE((xT - lds.xT).cwiseAbs().maxCoeff(), TOLERANCE * lds.xT.cwiseAbs().maxCoeff());
+    BOOST_CHECK_LE((intx - lds.intx).cwiseAbs().maxCoeff(), TOLERANCE * lds.intx.cwiseAbs().maxCoeff());
+    BOOST_CHECK_LE((int2x - lds.int2x).cwiseAbs().maxCoeff(), TOLERANCE * lds.int2x.cwiseAbs().maxCoeff());
+  }
+
+  template<int N>
+  void checkKernel(int n_contacts)
+  {
+    LDSKernel<N> kernel;
+    VectorXd xT(N), intx(N), int2x(N);
+    for(const double T : TIME_STEPS)
+    {
+      const ContactLDS lds = makeContactLDS(n_contacts, T);
+      kernel.compute(lds.A, lds.a, lds.x0, T, xT, intx, int2x);
+      checkResult(lds, xT, intx, int2x);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE ( BOOST_TEST_MODULE )
+
+BOOST_AUTO_TEST_CASE ( test_lds_kernel )
+{
+  std::srand(1);
+  checkKernel<6>(1);
+  checkKernel<12>(2);
+  checkKernel<18>(3);
+  checkKernel<24>(4);
+}
+
+BOOST_AUTO_TEST_CASE ( test_lds_integral_operators )
+{
+  std::srand(2);
+  LDSIntegralOperators operators;
+  operators.reserve(6*MAX_CONTACTS);
+  for(int n_contacts=1; n_contacts<=MAX_CONTACTS; ++n_contacts)
+  {
+    const int n = 6*n_contacts;
+    VectorXd xT(n), intx(n), int2x(n);
+    operators.resize(n);
+    for(const double T : TIME_STEPS)
+    {
+      const ContactLDS lds = makeContactLDS(n_contacts, T);
+      operators.compute(lds.A, T);
+      operators.apply(lds.a, lds.x0, xT, intx, int2x);
+      checkResult(lds, xT, intx, int2x);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE ( test_lds_expmv )
+{
+  std::srand(3);
+  LDSExpmv expmv;
+  expmv.reserve(6*MAX_CONTACTS);
+  for(int n_contacts=1; n_contacts<=MAX_CONTACTS; ++n_contacts)
+  {
+    const int n = 6*n_contacts;
+    VectorXd xT(n), intx(n), int2x(n);
+    expmv.resize(n);
+    for(const double T : TIME_STEPS)
+    {
+      const ContactLDS lds = makeContactLDS(n_contacts, T);
+      expmv.compute(lds.A, lds.a, lds.x0, T, xT, intx, int2x);
+      checkResult(lds, xT, intx, int2x);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE ( test_lds_modal )
+{
+  std::srand(4);
+  LDSModal modal;
+  modal.reserve(3*MAX_CONTACTS);
+  for(int n_contacts=1; n_contacts<=MAX_CONTACTS; ++n_contacts)
+  {
+    const int n = 6*n_contacts;
+    VectorXd xT(n), intx(n), int2x(n);
+    modal.resize(3*n_contacts);
+    for(const double T : TIME_STEPS)
+    {
+      const ContactLDS lds = makeContactLDS(n_contacts, T);
+      BOOST_REQUIRE(modal.compute(lds.Y, lds.K, lds.B, T));
+      modal.apply(lds.a, lds.x0, xT, intx, int2x);
+      checkResult(lds, xT, intx, int2x);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END ()
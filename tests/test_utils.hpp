@@ -1,9 +1,132 @@
 /**
- * Common Testing Utils 
- * 
- **/ 
+ * Common Testing Utils
+ *
+ **/
 
+#pragma once
 
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <pinocchio/multibody/model.hpp>
+#include <pinocchio/multibody/data.hpp>
+#include <pinocchio/algorithm/joint-configuration.hpp>
+#include <pinocchio/algorithm/frames.hpp>
 
-// create robot models from example-robot-data 
+#include "consim/object.hpp"
+#include "consim/contact.hpp"
+#include "consim/simulators/base.hpp"
 
+namespace consim
+{
+namespace test
+{
+
+  /**
+   * Robot model built in code (rather than loaded from example-robot-data), with its contact frames
+   * and a standing configuration
+   */
+  struct TestRobot
+  {
+    pinocchio::Model model;
+    std::vector<std::string> contact_frames;
+    Eigen::VectorXd q0;   /*!< standing configuration, all the contact points 0.1 mm below the floor */
+    Eigen::VectorXd v0;
+    double kp, kd;        /*!< gains of the joint PD controller of standingTorques */
+  };
+
+  /**
+   * adds a joint with a cylindrical link of the given length hanging along -z
+   */
+  inline pinocchio::JointIndex addLink(pinocchio::Model &model, pinocchio::JointIndex parent,
+                                       const pinocchio::JointModel &joint, const Eigen::Vector3d &offset,
+                                       const std::string &name, double mass, double length)
+  {
+    const pinocchio::JointIndex id = model.addJoint(parent, joint, pinocchio::SE3(Eigen::Matrix3d::Identity(), offset), name);
+    model.addJointFrame(id);
+    model.appendBodyToJoint(id, pinocchio::Inertia::FromCylinder(mass, 0.02, length),
+                            pinocchio::SE3(Eigen::Matrix3d::Identity(), Eigen::Vector3d(0., 0., -0.5*length)));
+    return id;
+  }
+
+  /**
+   * Quadruped with the kinematic layout and the masses of Solo12: free flyer and 3 joints per leg
+   * (HAA, HFE, KFE), one contact frame per foot
+   */
+  inline TestRobot buildQuadruped()
+  {
+    TestRobot robot;
+    pinocchio::Model &model = robot.model;
+    const pinocchio::JointIndex root = model.addJoint(0, pinocchio::JointModelFreeFlyer(), pinocchio::SE3::Identity(), "root_joint");
+    model.addJointFrame(root);
+    model.appendBodyToJoint(root, pinocchio::Inertia::FromBox(1.43, 0.39, 0.17, 0.05), pinocchio::SE3::Identity());
+
+    const char *legs[] = {"FL", "FR", "HL", "HR"};
+    const double x[] = {0.1946, 0.1946, -0.1946, -0.1946};
+    const double y[] = {0.0875, -0.0875, 0.0875, -0.0875};
+    for(int i=0; i<4; ++i){
+      const std::string leg(legs[i]);
+      pinocchio::JointIndex j = addLink(model, root, pinocchio::JointModelRX(), Eigen::Vector3d(x[i], y[i], 0.), leg+"_HAA", 0.15, 0.0);
+      j = addLink(model, j, pinocchio::JointModelRY(), Eigen::Vector3d(0., y[i]>0 ? 0.014 : -0.014, 0.), leg+"_HFE", 0.15, 0.16);
+      j = addLink(model, j, pinocchio::JointModelRY(), Eigen::Vector3d(0., 0., -0.16), leg+"_KFE", 0.03, 0.16);
+      model.addFrame(pinocchio::Frame(leg+"_FOOT", j, model.getFrameId(leg+"_KFE"),
+                                      pinocchio::SE3(Eigen::Matrix3d::Identity(), Eigen::Vector3d(0., 0., -0.16)),
+                                      pinocchio::OP_FRAME));
+      robot.contact_frames.push_back(leg+"_FOOT");
+    }
+
+    robot.q0 = pinocchio::neutral(model);
+    for(int i=0; i<4; ++i){
+      robot.q0(7+3*i+1) = 0.8;
+      robot.q0(7+3*i+2) = -1.6;
+    }
+    // lowest foot 0.1 mm below the floor
+    pinocchio::Data data(model);
+    pinocchio::framesForwardKinematics(model, data, robot.q0);
+    double z_min = 1e10;
+    for(const auto &name : robot.contact_frames)
+      z_min = std::min(z_min, data.oMf[model.getFrameId(name)].translation()(2));
+    robot.q0(2) -= z_min + 1e-4;
+    robot.v0 = Eigen::VectorXd::Zero(model.nv);
+    robot.kp = 10.0;
+    robot.kd = 0.05;
+    return robot;
+  }
+
+  /**
+   * Floor object with the linear penalty contact model of the Solo scripts (K = 1e5, B = 3e2, mu = 1)
+   */
+  inline ContactObject &getFloor()
+  {
+    static Eigen::Vector3d stiffness = 1e5*Eigen::Vector3d::Ones();
+    static Eigen::Vector3d damping = 3e2*Eigen::Vector3d::Ones();
+    static LinearPenaltyContactModel contact_model(stiffness, damping, 1.0);
+    static FloorObject floor("Floor", contact_model);
+    return floor;
+  }
+
+  /**
+   * adds the floor and all the contact points of the robot to the simulator and resets it to the standing configuration
+   */
+  inline void setupStanding(AbstractSimulator &sim, const TestRobot &robot)
+  {
+    sim.addObject(getFloor());
+    for(const auto &name : robot.contact_frames)
+      sim.addContactPoint(name, robot.model.getFrameId(name), true);
+    sim.resetState(robot.q0, robot.v0, true);
+  }
+
+  /**
+   * Joint PD controller holding the standing configuration (all the joints but the free flyer are revolute).
+   * tau must already have size nv, so that this does not allocate.
+   */
+  inline void standingTorques(const TestRobot &robot, const Eigen::VectorXd &q, const Eigen::VectorXd &v, Eigen::VectorXd &tau)
+  {
+    const int na = robot.model.nv-6;
+    tau.head<6>().setZero();
+    tau.tail(na) = robot.kp*(robot.q0.tail(na) - q.tail(na)) - robot.kd*v.tail(na);
+  }
+
+} // namespace test
+} // namespace consim